@@ -0,0 +1,143 @@
+//filename: arena.c
+/**
+ * Defines an arena of memory for blocks that are all freed together.
+ * The arena is a chain of chunks, each filled from the front by bumping an offset.  When a block
+ * does not fit in the current chunk a new one is chained in front of it, twice the size of the
+ * last up to a limit, or larger if the block itself needs it; the unused end of the old chunk
+ * is abandoned.  Destroying the arena frees every chunk, and so every block, in one pass.
+ */
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "arena.h"
+
+#define DEFAULT_CHUNK_LENGTH (64 * 1024)
+#define MAX_CHUNK_LENGTH (64 * 1024 * 1024)
+#define ARENA_ALIGNMENT 16
+
+typedef struct chunk {
+    struct chunk* next;            /* the chunk filled before this one */
+    size_t length;
+    size_t used;
+    _Alignas(ARENA_ALIGNMENT) char data[];
+} CHUNK;
+
+struct arena {
+    CHUNK* chunk;                  /* the chunk being filled */
+    size_t size;                   /* the bytes handed out, over all chunks */
+};
+
+/**
+ * Makes an empty chunk of at least the given length and chains it in front of the arena's
+ * current one.
+ *
+ * @param ap the arena
+ * @param length the number of bytes the chunk must hold
+ * @return the new chunk
+ * @timeComplexity O(1)
+ */
+static CHUNK* makeChunk(ARENA* ap, size_t length) {
+    CHUNK* cp = malloc(sizeof(CHUNK) + length);
+    assert(cp != NULL);
+    cp->next = ap->chunk;
+    cp->length = length;
+    cp->used = 0;
+    ap->chunk = cp;
+    return cp;
+}
+
+/**
+ * Creates a new empty arena.
+ *
+ * @param capacity the number of bytes the first chunk holds, or zero for a small default; an
+ *        estimate of the total lets a whole load fit in one chunk
+ * @return the new arena
+ * @timeComplexity O(1)
+ */
+ARENA* createArena(size_t capacity) {
+    ARENA* ap = malloc(sizeof(ARENA));
+    assert(ap != NULL);
+    ap->chunk = NULL;
+    ap->size = 0;
+    makeChunk(ap, capacity > 0 ? capacity : DEFAULT_CHUNK_LENGTH);
+    return ap;
+}
+
+/**
+ * Destroys the arena and frees all memory associated with it, including every block allocated
+ * from it.
+ *
+ * @param ap the arena to destroy
+ * @timeComplexity O(C) where C is the number of chunks
+ */
+void destroyArena(ARENA* ap) {
+    assert(ap != NULL);
+    CHUNK* cp = ap->chunk;
+    while (cp != NULL) {
+        CHUNK* next = cp->next;
+        free(cp);
+        cp = next;
+    }
+    free(ap);
+}
+
+/**
+ * Allocates a block from the arena, aligned for any item of up to sixteen bytes.  The block
+ * lives until the arena is destroyed.
+ *
+ * @param ap the arena
+ * @param n the size of the block in bytes
+ * @return the address of the block
+ * @timeComplexity O(1)
+ */
+void* arenaAlloc(ARENA* ap, size_t n) {
+    assert(ap != NULL);
+    CHUNK* cp = ap->chunk;
+    size_t start = (cp->used + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+    if (start > cp->length || n > cp->length - start) {
+        size_t length = cp->length < MAX_CHUNK_LENGTH ? 2 * cp->length : cp->length;
+        cp = makeChunk(ap, n > length ? n : length);
+        start = 0;
+    }
+    cp->used = start + n;
+    ap->size += n;
+    return cp->data + start;
+}
+
+/**
+ * Copies n bytes into the arena as a null-terminated string.  Strings copied in turn are packed
+ * end to end, with no alignment between them.
+ *
+ * @param ap the arena
+ * @param s the bytes to copy (cant be null unless n is zero)
+ * @param n the number of bytes
+ * @return the address of the copy
+ * @timeComplexity O(n)
+ */
+char* arenaCopy(ARENA* ap, const char* s, size_t n) {
+    assert(ap != NULL);
+    CHUNK* cp = ap->chunk;
+    if (n >= cp->length - cp->used) {
+        size_t length = cp->length < MAX_CHUNK_LENGTH ? 2 * cp->length : cp->length;
+        cp = makeChunk(ap, n >= length ? n + 1 : length);
+    }
+    char* copy = cp->data + cp->used;
+    memcpy(copy, s, n);
+    copy[n] = '\0';
+    cp->used += n + 1;
+    ap->size += n + 1;
+    return copy;
+}
+
+/**
+ * Returns the number of bytes allocated from the arena, not counting the space lost to
+ * alignment and at the end of each chunk.
+ *
+ * @param ap the arena
+ * @return the number of bytes
+ * @timeComplexity O(1)
+ */
+size_t arenaSize(ARENA* ap) {
+    assert(ap != NULL);
+    return ap->size;
+}
@@ -0,0 +1,29 @@
+/*
+ * File:	arena.h
+ *
+ * Description:	This file contains the public function and type
+ *		declarations for an arena, a region of memory from which
+ *		many small blocks, such as strings, are carved in order
+ *		and then freed all at once when the arena is destroyed.
+ *		The blocks are packed one after another in large chunks,
+ *		so there is no per-block header or call to free.
+ */
+
+# ifndef ARENA_H
+# define ARENA_H
+
+# include <stddef.h>
+
+typedef struct arena ARENA;
+
+extern ARENA *createArena(size_t capacity);
+
+extern void destroyArena(ARENA *ap);
+
+extern void *arenaAlloc(ARENA *ap, size_t n);
+
+extern char *arenaCopy(ARENA *ap, const char *s, size_t n);
+
+extern size_t arenaSize(ARENA *ap);
+
+# endif /* ARENA_H */
@@ -0,0 +1,549 @@
+/*
+ * File:	benchmark.c
+ *
+ * Description:	Measure the performance of the list.  The micro-benchmarks
+ *		time each list operation at sizes from 10 up to the size
+ *		given by the -n option, in powers of ten, along with the
+ *		same operation on a plain dynamic array of pointers as a
+ *		baseline.  The macro-benchmarks run the radix and qsort
+ *		programs on generated inputs of the size given by the -m
+ *		option, once with ordinary storage and once with the -H
+ *		option, which maps the list on huge pages.  Every case
+ *		runs in a child process, so that its peak resident set
+ *		size can be reported along with its time.  For the
+ *		programs, the data TLB misses are also counted with
+ *		perf_event_open, where the system allows it, along with
+ *		the minor page faults.  The results are written as JSON
+ *		to the standard output.
+ *
+ *		Inserting or removing at the front of a plain array takes
+ *		time proportional to its length, so the baseline for those
+ *		operations is skipped above ARRAY_FRONT_MAX items.
+ */
+
+# include <time.h>
+# include <stdio.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include <string.h>
+# include <assert.h>
+# include <unistd.h>
+# include <sys/wait.h>
+# include <sys/syscall.h>
+# include <sys/resource.h>
+# include <linux/perf_event.h>
+# include "list.h"
+
+# define MIN_OPS	1000000		/* fewest operations timed per case */
+# define ARRAY_FRONT_MAX 100000		/* largest array grown at the front */
+# define WORD_LENGTH	12		/* longest generated word */
+
+typedef struct array ARRAY;
+
+struct array {
+    void **items;
+    long count, capacity;
+};
+
+static const char *ops[] = {
+    "addFirst", "addLast", "removeFirst", "removeLast",
+    "getItemSequential", "getItemRandom", "setItem"
+};
+
+# define NUM_OPS ((int) (sizeof(ops) / sizeof(ops[0])))
+
+
+/*
+ * Function:	now
+ *
+ * Description:	Return the time in seconds from a monotonic clock.
+ */
+
+static double now(void)
+{
+    struct timespec ts;
+
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*
+ * Function:	item
+ *
+ * Description:	Return the pointer stored as the ith item.  Lists do not
+ *		allow null items, so the pointers start at one.
+ */
+
+static void *item(long i)
+{
+    return (void *) (intptr_t) (i + 1);
+}
+
+
+/*
+ * Function:	nextIndex
+ *
+ * Description:	Return a pseudo-random index less than n, using a
+ *		xorshift generator so that both implementations pay the
+ *		same small cost for it.
+ */
+
+static long nextIndex(uint64_t *state, long n)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state % n;
+}
+
+
+/*
+ * Function:	arrayGrow, arrayAddFirst, arrayAddLast
+ *
+ * Description:	Add an item to either end of a plain array, doubling its
+ *		capacity first if it is full.
+ */
+
+static void arrayGrow(ARRAY *ap)
+{
+    if (ap->count == ap->capacity) {
+	ap->capacity = ap->capacity > 0 ? ap->capacity * 2 : 8;
+	ap->items = realloc(ap->items, sizeof(void *) * ap->capacity);
+	assert(ap->items != NULL);
+    }
+}
+
+static void arrayAddFirst(ARRAY *ap, void *x)
+{
+    arrayGrow(ap);
+    memmove(ap->items + 1, ap->items, sizeof(void *) * ap->count ++);
+    ap->items[0] = x;
+}
+
+static void arrayAddLast(ARRAY *ap, void *x)
+{
+    arrayGrow(ap);
+    ap->items[ap->count ++] = x;
+}
+
+
+/*
+ * Function:	timeList
+ *
+ * Description:	Time one operation on a list of n items, repeating it
+ *		until at least MIN_OPS operations have been timed, and
+ *		return the nanoseconds per operation.  Building the list
+ *		for the operations that need one is not timed.
+ */
+
+static double timeList(int op, long n)
+{
+    long i, j, reps, total;
+    uint64_t state;
+    double start, elapsed;
+    volatile void *sink;
+    LIST *lp;
+
+
+    reps = (MIN_OPS + n - 1) / n;
+    total = 0;
+    elapsed = 0;
+    state = 88172645463325252ull;
+
+    for (j = 0; j < reps; j ++) {
+	lp = createList();
+
+	if (op >= 2)
+	    for (i = 0; i < n; i ++)
+		addLast(lp, item(i));
+
+	start = now();
+
+	switch (op) {
+	case 0:
+	    for (i = 0; i < n; i ++)
+		addFirst(lp, item(i));
+	    break;
+
+	case 1:
+	    for (i = 0; i < n; i ++)
+		addLast(lp, item(i));
+	    break;
+
+	case 2:
+	    for (i = 0; i < n; i ++)
+		sink = removeFirst(lp);
+	    break;
+
+	case 3:
+	    for (i = 0; i < n; i ++)
+		sink = removeLast(lp);
+	    break;
+
+	case 4:
+	    for (i = 0; i < n; i ++)
+		sink = getItem(lp, i);
+	    break;
+
+	case 5:
+	    for (i = 0; i < n; i ++)
+		sink = getItem(lp, nextIndex(&state, n));
+	    break;
+
+	case 6:
+	    for (i = 0; i < n; i ++)
+		setItem(lp, i, item(n - i));
+	    break;
+	}
+
+	elapsed += now() - start;
+	total += n;
+	destroyList(lp);
+    }
+
+    (void) sink;
+    return elapsed * 1e9 / total;
+}
+
+
+/*
+ * Function:	timeArray
+ *
+ * Description:	Time one operation on a plain array of n items, in the
+ *		same way as timeList.
+ */
+
+static double timeArray(int op, long n)
+{
+    long i, j, reps, total;
+    uint64_t state;
+    double start, elapsed;
+    volatile void *sink;
+    ARRAY a;
+
+
+    reps = (MIN_OPS + n - 1) / n;
+    total = 0;
+    elapsed = 0;
+    state = 88172645463325252ull;
+
+    for (j = 0; j < reps; j ++) {
+	a.items = NULL;
+	a.count = a.capacity = 0;
+
+	if (op >= 2)
+	    for (i = 0; i < n; i ++)
+		arrayAddLast(&a, item(i));
+
+	start = now();
+
+	switch (op) {
+	case 0:
+	    for (i = 0; i < n; i ++)
+		arrayAddFirst(&a, item(i));
+	    break;
+
+	case 1:
+	    for (i = 0; i < n; i ++)
+		arrayAddLast(&a, item(i));
+	    break;
+
+	case 2:
+	    for (i = 0; i < n; i ++) {
+		sink = a.items[0];
+		memmove(a.items, a.items + 1, sizeof(void *) * -- a.count);
+	    }
+	    break;
+
+	case 3:
+	    for (i = 0; i < n; i ++)
+		sink = a.items[-- a.count];
+	    break;
+
+	case 4:
+	    for (i = 0; i < n; i ++)
+		sink = a.items[i];
+	    break;
+
+	case 5:
+	    for (i = 0; i < n; i ++)
+		sink = a.items[nextIndex(&state, n)];
+	    break;
+
+	case 6:
+	    for (i = 0; i < n; i ++)
+		a.items[i] = item(n - i);
+	    break;
+	}
+
+	elapsed += now() - start;
+	total += n;
+	free(a.items);
+    }
+
+    (void) sink;
+    return elapsed * 1e9 / total;
+}
+
+
+/*
+ * Function:	runMicro
+ *
+ * Description:	Run one micro-benchmark in a child process, which sends
+ *		back the time per operation through a pipe, and print
+ *		its result as a JSON object.
+ */
+
+static void runMicro(int op, const char *impl, long n, bool first)
+{
+    int fds[2], status;
+    double ns;
+    pid_t pid;
+    struct rusage usage;
+
+
+    if (pipe(fds) != 0) {
+	perror("pipe");
+	exit(EXIT_FAILURE);
+    }
+
+    fflush(stdout);
+    pid = fork();
+    assert(pid >= 0);
+
+    if (pid == 0) {
+	close(fds[0]);
+	ns = strcmp(impl, "list") == 0 ? timeList(op, n) : timeArray(op, n);
+	_exit(write(fds[1], &ns, sizeof(ns)) == sizeof(ns) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(fds[1]);
+
+    if (read(fds[0], &ns, sizeof(ns)) != sizeof(ns))
+	ns = -1;
+
+    close(fds[0]);
+    wait4(pid, &status, 0, &usage);
+
+    printf("%s\n    {\"op\": \"%s\", \"impl\": \"%s\", \"n\": %ld, ", first ? "" : ",", ops[op], impl, n);
+
+    if (ns < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	printf("\"ns_per_op\": null, \"ops_per_sec\": null, ");
+    else
+	printf("\"ns_per_op\": %.3f, \"ops_per_sec\": %.0f, ", ns, 1e9 / ns);
+
+    printf("\"peak_rss_kb\": %ld}", usage.ru_maxrss);
+}
+
+
+/*
+ * Function:	makeInput
+ *
+ * Description:	Write n random non-negative integers, or n random words,
+ *		to a new temporary file and return its name.
+ */
+
+static char *makeInput(long n, bool words)
+{
+    int fd, j, len;
+    long i;
+    char *name, word[WORD_LENGTH + 1];
+    FILE *fp;
+
+
+    name = strdup("/tmp/benchXXXXXX");
+    fd = mkstemp(name);
+    assert(fd >= 0);
+    fp = fdopen(fd, "w");
+    assert(fp != NULL);
+
+    for (i = 0; i < n; i ++) {
+	if (words) {
+	    len = 1 + rand() % WORD_LENGTH;
+
+	    for (j = 0; j < len; j ++)
+		word[j] = 'a' + rand() % 26;
+
+	    word[len] = '\0';
+	    fprintf(fp, "%s\n", word);
+	} else
+	    fprintf(fp, "%d\n", rand() % 1000000000);
+    }
+
+    fclose(fp);
+    return name;
+}
+
+
+/*
+ * Function:	openCounter
+ *
+ * Description:	Open a counter of the data TLB read misses in user space
+ *		of the given process, starting when it next calls exec.
+ *		Return the descriptor, or -1 if the system has no such
+ *		counter or does not allow it.
+ */
+
+static int openCounter(pid_t pid)
+{
+    struct perf_event_attr attr;
+
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+	PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0);
+}
+
+
+/*
+ * Function:	runMacro
+ *
+ * Description:	Run one of the programs on an input file, discarding its
+ *		output, and print its time, throughput, data TLB misses,
+ *		minor page faults, and peak resident set size as a JSON
+ *		object.  The child waits on a pipe until its counter has
+ *		been opened.
+ */
+
+static void runMacro(const char *program, const char *input, long n, bool huge, bool first)
+{
+    int fds[2], status, counter;
+    char go;
+    long long misses;
+    double start, elapsed;
+    pid_t pid;
+    struct rusage usage;
+
+
+    if (pipe(fds) != 0) {
+	perror("pipe");
+	exit(EXIT_FAILURE);
+    }
+
+    fflush(stdout);
+    start = now();
+    pid = fork();
+    assert(pid >= 0);
+
+    if (pid == 0) {
+	close(fds[1]);
+
+	if (read(fds[0], &go, 1) != 1)
+	    _exit(EXIT_FAILURE);
+
+	if (freopen("/dev/null", "w", stdout) == NULL)
+	    _exit(EXIT_FAILURE);
+
+	if (strcmp(program, "radix") == 0) {
+	    if (freopen(input, "r", stdin) == NULL)
+		_exit(EXIT_FAILURE);
+
+	    execl("./radix", "radix", huge ? "-H" : "-j1", (char *) NULL);
+	} else
+	    execl("./qsort", "qsort", huge ? "-H" : "-j1", input, (char *) NULL);
+
+	_exit(EXIT_FAILURE);
+    }
+
+    close(fds[0]);
+    counter = openCounter(pid);
+    go = 1;
+
+    if (write(fds[1], &go, 1) != 1)
+	perror("write");
+
+    close(fds[1]);
+    wait4(pid, &status, 0, &usage);
+    elapsed = now() - start;
+
+    if (counter < 0 || read(counter, &misses, sizeof(misses)) != sizeof(misses))
+	misses = -1;
+
+    if (counter >= 0)
+	close(counter);
+
+    printf("%s\n    {\"program\": \"%s\", \"huge\": %s, \"n\": %ld, ",
+	first ? "" : ",", program, huge ? "true" : "false", n);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	printf("\"seconds\": null, \"items_per_sec\": null, ");
+    else
+	printf("\"seconds\": %.3f, \"items_per_sec\": %.0f, ", elapsed, n / elapsed);
+
+    if (misses < 0)
+	printf("\"dtlb_misses\": null, ");
+    else
+	printf("\"dtlb_misses\": %lld, ", misses);
+
+    printf("\"minor_faults\": %ld, \"peak_rss_kb\": %ld}", usage.ru_minflt, usage.ru_maxrss);
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Driver function for the benchmark application.
+ */
+
+int main(int argc, char *argv[])
+{
+    int c, op;
+    long n, maxMicro, macro;
+    bool first;
+    char *numbers, *words;
+
+
+    maxMicro = 100000000;
+    macro = 1000000;
+
+    while ((c = getopt(argc, argv, "n:m:")) != -1) {
+	if (c == 'n' && atol(optarg) >= 10)
+	    maxMicro = atol(optarg);
+
+	else if (c == 'm' && atol(optarg) > 0)
+	    macro = atol(optarg);
+
+	else {
+	    fprintf(stderr, "usage: %s [-n max-size] [-m macro-size]\n", argv[0]);
+	    exit(EXIT_FAILURE);
+	}
+    }
+
+    printf("{\n  \"micro\": [");
+    first = true;
+
+    for (op = 0; op < NUM_OPS; op ++)
+	for (n = 10; n <= maxMicro; n *= 10) {
+	    runMicro(op, "list", n, first);
+	    first = false;
+
+	    if ((op != 0 && op != 2) || n <= ARRAY_FRONT_MAX)
+		runMicro(op, "array", n, first);
+	}
+
+    printf("\n  ],\n  \"macro\": [");
+    srand(1);
+    numbers = makeInput(macro, false);
+    words = makeInput(macro, true);
+    runMacro("radix", numbers, macro, false, true);
+    runMacro("radix", numbers, macro, true, false);
+    runMacro("qsort", words, macro, false, false);
+    runMacro("qsort", words, macro, true, false);
+    printf("\n  ]\n}\n");
+
+    unlink(numbers);
+    unlink(words);
+    free(numbers);
+    free(words);
+    exit(EXIT_SUCCESS);
+}
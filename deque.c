@@ -0,0 +1,189 @@
+//filename: deque.c
+/**
+ * Defines a concurrent work-stealing deque, following Chase and Lev, "Dynamic Circular
+ * Work-Stealing Deque" (SPAA 2005), with the C11 orderings of Le et al., "Correct and Efficient
+ * Work-Stealing for Weak Memory Models" (PPoPP 2013).
+ * The items live in a power-of-two ring indexed by two ever-increasing positions: the owner
+ * pushes and pops at the bottom and thieves claim the top with a compare-and-swap.  Each slot
+ * holds one item packed into an atomic 64-bit word, so a thief that loses a race never reads a
+ * torn item.  When the ring fills the owner copies it into one twice the size; the old ring is
+ * kept until the deque is destroyed, since a slow thief may still be reading it.
+ */
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "deque.h"
+
+#define DEFAULT_DEQUE_LENGTH 64
+#define CACHE_LINE 64
+
+typedef struct ring {
+    long mask;
+    struct ring* retired;          /* the ring this one replaced */
+    _Atomic uint64_t slots[];
+} RING;
+
+struct deque {
+    size_t elemSize;
+    _Atomic(RING*) ring;
+    _Alignas(CACHE_LINE) atomic_long top;
+    _Alignas(CACHE_LINE) atomic_long bottom;
+};
+
+/**
+ * Makes an empty ring of the given length.
+ *
+ * @param length the number of slots, a power of two
+ * @param retired the ring that the new one replaces (can be null)
+ * @return the new ring
+ * @timeComplexity O(1)
+ */
+static RING* makeRing(long length, RING* retired) {
+    RING* rp = malloc(sizeof(RING) + length * sizeof(uint64_t));
+    assert(rp != NULL);
+    rp->mask = length - 1;
+    rp->retired = retired;
+    return rp;
+}
+
+/**
+ * Creates a new empty deque of items of the given size.
+ *
+ * @param elemSize the size of each item in bytes, at most eight
+ * @return the new deque
+ * @timeComplexity O(1)
+ */
+DEQUE* createDeque(size_t elemSize) {
+    assert(elemSize > 0 && elemSize <= sizeof(uint64_t));
+    DEQUE* dp = aligned_alloc(CACHE_LINE, sizeof(DEQUE));
+    assert(dp != NULL);
+    dp->elemSize = elemSize;
+    atomic_init(&dp->ring, makeRing(DEFAULT_DEQUE_LENGTH, NULL));
+    atomic_init(&dp->top, 0);
+    atomic_init(&dp->bottom, 0);
+    return dp;
+}
+
+/**
+ * Destroys the deque and frees all memory associated with it, including every ring it has
+ * outgrown.  No thread may be using the deque.
+ *
+ * @param dp the deque to destroy
+ * @timeComplexity O(R) where R is the number of rings
+ */
+void destroyDeque(DEQUE* dp) {
+    assert(dp != NULL);
+    RING* rp = atomic_load_explicit(&dp->ring, memory_order_relaxed);
+    while (rp != NULL) {
+        RING* retired = rp->retired;
+        free(rp);
+        rp = retired;
+    }
+    free(dp);
+}
+
+/**
+ * Returns the number of items in the deque.  The count is only a snapshot if other threads are
+ * using the deque.
+ *
+ * @param dp the deque
+ * @return the number of items
+ * @timeComplexity O(1)
+ */
+int dequeSize(DEQUE* dp) {
+    assert(dp != NULL);
+    long bottom = atomic_load_explicit(&dp->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&dp->top, memory_order_relaxed);
+    return bottom > top ? bottom - top : 0;
+}
+
+/**
+ * Adds an item at the bottom of the deque, growing the ring if it is full.  Called by the owner
+ * only.
+ *
+ * @param dp the deque to add to
+ * @param elem the address of the item to copy in (cant be null)
+ * @timeComplexity O(1) amortized
+ */
+void dequePush(DEQUE* dp, const void* elem) {
+    assert(dp != NULL && elem != NULL);
+    long bottom = atomic_load_explicit(&dp->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&dp->top, memory_order_acquire);
+    RING* rp = atomic_load_explicit(&dp->ring, memory_order_relaxed);
+    if (bottom - top > rp->mask) {
+        RING* bigger = makeRing(2 * (rp->mask + 1), rp);
+        for (long i = top; i < bottom; i++) {
+            uint64_t word = atomic_load_explicit(&rp->slots[i & rp->mask], memory_order_relaxed);
+            atomic_store_explicit(&bigger->slots[i & bigger->mask], word, memory_order_relaxed);
+        }
+        atomic_store_explicit(&dp->ring, bigger, memory_order_release);
+        rp = bigger;
+    }
+    uint64_t word = 0;
+    memcpy(&word, elem, dp->elemSize);
+    atomic_store_explicit(&rp->slots[bottom & rp->mask], word, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&dp->bottom, bottom + 1, memory_order_relaxed);
+}
+
+/**
+ * Removes the item at the bottom of the deque, the one most recently pushed, if a thief has not
+ * taken it.  Called by the owner only.
+ *
+ * @param dp the deque to remove from
+ * @param out where to copy the item (can be null)
+ * @return true if an item was removed, false if the deque is empty
+ * @timeComplexity O(1)
+ */
+bool dequePop(DEQUE* dp, void* out) {
+    assert(dp != NULL);
+    long bottom = atomic_load_explicit(&dp->bottom, memory_order_relaxed) - 1;
+    RING* rp = atomic_load_explicit(&dp->ring, memory_order_relaxed);
+    atomic_store_explicit(&dp->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&dp->top, memory_order_relaxed);
+    if (top > bottom) {
+        atomic_store_explicit(&dp->bottom, bottom + 1, memory_order_relaxed);
+        return false;
+    }
+    uint64_t word = atomic_load_explicit(&rp->slots[bottom & rp->mask], memory_order_relaxed);
+    if (top == bottom) {
+        bool won = atomic_compare_exchange_strong_explicit(&dp->top, &top, top + 1, memory_order_seq_cst,
+                                                           memory_order_relaxed);
+        atomic_store_explicit(&dp->bottom, bottom + 1, memory_order_relaxed);
+        if (!won)
+            return false;
+    }
+    if (out != NULL)
+        memcpy(out, &word, dp->elemSize);
+    return true;
+}
+
+/**
+ * Removes the item at the top of the deque, the oldest one.  Called by any thread other than
+ * the owner.
+ *
+ * @param dp the deque to steal from
+ * @param out where to copy the item (can be null)
+ * @return true if an item was stolen, false if the deque was empty or another thread took the
+ *         item first
+ * @timeComplexity O(1)
+ */
+bool dequeSteal(DEQUE* dp, void* out) {
+    assert(dp != NULL);
+    long top = atomic_load_explicit(&dp->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long bottom = atomic_load_explicit(&dp->bottom, memory_order_acquire);
+    if (top >= bottom)
+        return false;
+    RING* rp = atomic_load_explicit(&dp->ring, memory_order_acquire);
+    uint64_t word = atomic_load_explicit(&rp->slots[top & rp->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&dp->top, &top, top + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed))
+        return false;
+    if (out != NULL)
+        memcpy(out, &word, dp->elemSize);
+    return true;
+}
@@ -0,0 +1,33 @@
+/*
+ * File:	deque.h
+ *
+ * Description:	This file contains the public function and type
+ *		declarations for a concurrent work-stealing deque of
+ *		small items stored by value, after Chase and Lev.  The
+ *		owning thread adds and removes items at the bottom, like
+ *		addLast and removeLast on a list, while any other thread
+ *		may steal items from the top, like removeFirst.  Items
+ *		may be at most eight bytes.
+ */
+
+# ifndef DEQUE_H
+# define DEQUE_H
+
+# include <stddef.h>
+# include <stdbool.h>
+
+typedef struct deque DEQUE;
+
+extern DEQUE *createDeque(size_t elemSize);
+
+extern void destroyDeque(DEQUE *dp);
+
+extern int dequeSize(DEQUE *dp);
+
+extern void dequePush(DEQUE *dp, const void *elem);
+
+extern bool dequePop(DEQUE *dp, void *out);
+
+extern bool dequeSteal(DEQUE *dp, void *out);
+
+# endif /* DEQUE_H */
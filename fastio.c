@@ -0,0 +1,596 @@
+//filename: fastio.c
+/**
+ * Defines fast input and output for the radix and qsort programs.
+ * Input is mapped read-only when it is a regular file and read into a single buffer otherwise,
+ * then scanned eight bytes at a time: each 64-bit word is classified with branch-free byte
+ * range tests, so a run of digits or of word characters is skipped a word at a time, and up to
+ * eight digits are converted to an integer with three multiplications.  Output is gathered in
+ * a large buffer and written with write, or with writev when a string does not fit.
+ */
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "fastio.h"
+#include "queue.h"
+
+#define INPUT_CHUNK (1 << 20)
+#define OUTPUT_LENGTH (1 << 20)
+#define LOAD_BATCH 4096
+#define BYTE_ONES 0x0101010101010101ull
+#define BYTE_HIGHS 0x8080808080808080ull
+
+struct input {
+    const char* data;
+    size_t length;
+    size_t pos;
+    bool mapped;
+};
+
+struct output {
+    int fd;
+    bool failed;
+    size_t used;
+    char data[OUTPUT_LENGTH];
+};
+
+typedef struct loadjob {
+    INPUT* ip;
+    QUEUE* qp;
+    int (*scan)(INPUT* ip, void* context, void* out, int max);
+    void* context;
+    size_t elemSize;
+} LOAD_JOB;
+
+static const uint32_t powersOfTen[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+/**
+ * Opens a file, or the standard input if the path is null, for scanning.  A regular file is
+ * mapped; anything else is read in whole.
+ *
+ * @param path the name of the file (can be null)
+ * @return the input, or null if the file cannot be opened or read
+ * @timeComplexity O(1) when mapped; O(L) otherwise where L is the length of the input
+ */
+INPUT* openInput(const char* path) {
+    int fd = path != NULL ? open(path, O_RDONLY) : STDIN_FILENO;
+    if (fd < 0)
+        return NULL;
+    INPUT* ip = malloc(sizeof(INPUT));
+    assert(ip != NULL);
+    ip->pos = 0;
+    ip->mapped = false;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+            off_t start = lseek(fd, 0, SEEK_CUR);
+            ip->data = data;
+            ip->length = st.st_size;
+            ip->pos = start > 0 && start < st.st_size ? start : 0;
+            ip->mapped = true;
+        }
+    }
+
+    if (!ip->mapped) {
+        size_t capacity = INPUT_CHUNK, length = 0;
+        char* data = malloc(capacity);
+        ssize_t n;
+        assert(data != NULL);
+        while ((n = read(fd, data + length, capacity - length)) > 0) {
+            length += n;
+            if (length == capacity) {
+                capacity *= 2;
+                data = realloc(data, capacity);
+                assert(data != NULL);
+            }
+        }
+        if (n < 0) {
+            free(data);
+            free(ip);
+            ip = NULL;
+        } else {
+            ip->data = data;
+            ip->length = length;
+        }
+    }
+
+    if (path != NULL)
+        close(fd);
+    return ip;
+}
+
+/**
+ * Closes an input, releasing its mapping or buffer.
+ *
+ * @param ip the input to close
+ * @timeComplexity O(1)
+ */
+void closeInput(INPUT* ip) {
+    assert(ip != NULL);
+    if (ip->mapped)
+        munmap((void*) ip->data, ip->length);
+    else
+        free((void*) ip->data);
+    free(ip);
+}
+
+/**
+ * Loads the eight bytes of input at the given position as a word whose lowest byte is the
+ * first, padding with zeros past the end of the input.
+ *
+ * @param ip the input
+ * @param pos the position of the first byte
+ * @return the word
+ * @timeComplexity O(1)
+ */
+static inline uint64_t loadWord(INPUT* ip, size_t pos) {
+    uint64_t w = 0;
+    if (pos + sizeof(w) <= ip->length)
+        memcpy(&w, ip->data + pos, sizeof(w));
+    else if (pos < ip->length)
+        memcpy(&w, ip->data + pos, ip->length - pos);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    w = __builtin_bswap64(w);
+#endif
+    return w;
+}
+
+/**
+ * Returns a mask with the high bit set in each byte of a word that lies between lo and hi
+ * inclusive, where both are below 0x80.  Adding to the low seven bits of each byte can never
+ * carry into the next byte, so every byte is tested exactly.
+ *
+ * @param w the word
+ * @param lo the smallest byte value to match
+ * @param hi the largest byte value to match
+ * @return the mask
+ * @timeComplexity O(1)
+ */
+static inline uint64_t byteRange(uint64_t w, unsigned lo, unsigned hi) {
+    uint64_t low = w & ~BYTE_HIGHS;
+    uint64_t atLeast = low + BYTE_ONES * (0x80 - lo);
+    uint64_t above = low + BYTE_ONES * (0x7f - hi);
+    return atLeast & ~above & ~w & BYTE_HIGHS;
+}
+
+/**
+ * Returns a mask of the bytes of a word that are white space, as isspace defines it.
+ *
+ * @param w the word
+ * @return the mask
+ * @timeComplexity O(1)
+ */
+static inline uint64_t spaceMask(uint64_t w) {
+    return byteRange(w, '\t', '\r') | byteRange(w, ' ', ' ');
+}
+
+/**
+ * Converts the decimal digits in the first k bytes of a word to an integer, shifting them to
+ * the top so that the bytes below read as leading zeros and then combining pairs of digits,
+ * pairs of pairs, and pairs of those with one multiplication each.
+ *
+ * @param w the word, its first byte the most significant digit
+ * @param k the number of digits, from one to eight
+ * @return the value
+ * @timeComplexity O(1)
+ */
+static inline uint32_t parseDigits(uint64_t w, unsigned k) {
+    w <<= 8 * (8 - k);
+    w = (w & 0x0f0f0f0f0f0f0f0full) * 2561 >> 8;
+    w = (w & 0x00ff00ff00ff00ffull) * 6553601 >> 16;
+    return (w & 0x0000ffff0000ffffull) * 42949672960001ull >> 32;
+}
+
+/**
+ * Skips the white space at the current position of the input.
+ *
+ * @param ip the input
+ * @timeComplexity O(S) where S is the number of bytes skipped
+ */
+static void skipSpaces(INPUT* ip) {
+    while (ip->pos < ip->length) {
+        uint64_t other = ~spaceMask(loadWord(ip, ip->pos)) & BYTE_HIGHS;
+        if (other != 0) {
+            ip->pos += __builtin_ctzll(other) / 8;
+            break;
+        }
+        ip->pos += 8;
+    }
+    if (ip->pos > ip->length)
+        ip->pos = ip->length;
+}
+
+/**
+ * Returns the next byte of the input that is not white space, without consuming it.
+ *
+ * @param ip the input
+ * @return the byte, or -1 at the end of the input
+ * @timeComplexity O(S) where S is the number of bytes skipped
+ */
+int peekInput(INPUT* ip) {
+    assert(ip != NULL);
+    skipSpaces(ip);
+    return ip->pos < ip->length ? (unsigned char) ip->data[ip->pos] : -1;
+}
+
+/**
+ * Scans up to max non-negative decimal integers separated by white space.  Scanning stops
+ * early at the end of the input, at anything that does not start with a digit, such as a
+ * minus sign, or at a number too large for an int; what stopped it is left to be read by
+ * peekInput.  Digits stop being accumulated as soon as the value exceeds INT_MAX, so a long
+ * run of digits cannot wrap around to a small value.
+ *
+ * @param ip the input
+ * @param out where to store the integers
+ * @param max the largest number of integers to scan
+ * @return the number of integers scanned
+ * @timeComplexity O(n) where n is the number of bytes scanned
+ */
+int scanInts(INPUT* ip, int* out, int max) {
+    assert(ip != NULL && out != NULL && max >= 0);
+    int n = 0;
+    while (n < max) {
+        skipSpaces(ip);
+        uint64_t value = 0;
+        size_t start = ip->pos;
+        while (true) {
+            uint64_t w = loadWord(ip, ip->pos);
+            uint64_t other = ~byteRange(w, '0', '9') & BYTE_HIGHS;
+            unsigned k = other != 0 ? __builtin_ctzll(other) / 8 : 8;
+            if (k == 0)
+                break;
+            value = value * powersOfTen[k] + parseDigits(w, k);
+            ip->pos += k;
+            if (k < 8 || value > INT_MAX)
+                break;
+        }
+        if (ip->pos == start || value > INT_MAX) {
+            ip->pos = start;
+            break;
+        }
+        out[n++] = value;
+    }
+    return n;
+}
+
+/**
+ * Scans up to max words separated by white space.  The words are not copied or terminated:
+ * each is returned as its address in the input and its length.
+ *
+ * @param ip the input
+ * @param words where to store the address of each word
+ * @param lengths where to store the length of each word
+ * @param max the largest number of words to scan
+ * @return the number of words scanned, which is less than max only at the end of the input
+ * @timeComplexity O(n) where n is the number of bytes scanned
+ */
+int scanWords(INPUT* ip, const char** words, size_t* lengths, int max) {
+    assert(ip != NULL && words != NULL && lengths != NULL && max >= 0);
+    int n = 0;
+    while (n < max) {
+        skipSpaces(ip);
+        if (ip->pos == ip->length)
+            break;
+        size_t start = ip->pos;
+        while (ip->pos < ip->length) {
+            uint64_t spaces = spaceMask(loadWord(ip, ip->pos));
+            if (spaces != 0) {
+                ip->pos += __builtin_ctzll(spaces) / 8;
+                break;
+            }
+            ip->pos += 8;
+        }
+        if (ip->pos > ip->length)
+            ip->pos = ip->length;
+        words[n] = ip->data + start;
+        lengths[n++] = ip->pos - start;
+    }
+    return n;
+}
+
+/**
+ * Scans up to max integers for a load, adapting scanInts to the signature of a scan function.
+ */
+static int scanIntBatch(INPUT* ip, void* context, void* out, int max) {
+    (void) context;
+    return scanInts(ip, out, max);
+}
+
+/**
+ * Returns the first eight bytes of a word packed big-endian into an integer, padded with zeros
+ * after the word's end or its first null byte, so that comparing two prefixes as integers
+ * orders them as strcmp would.
+ *
+ * @param ip the input
+ * @param pos the position of the word
+ * @param length the length of the word
+ * @return the prefix
+ * @timeComplexity O(1)
+ */
+static inline uint64_t wordPrefix(INPUT* ip, size_t pos, size_t length) {
+    uint64_t w = loadWord(ip, pos);
+    uint64_t nulls = byteRange(w, 0, 0);
+    size_t before = nulls != 0 ? (size_t) __builtin_ctzll(nulls) / 8 : sizeof(w);
+    if (before < length)
+        length = before;
+    if (length < sizeof(w))
+        w &= (1ull << 8 * length) - 1;
+    return __builtin_bswap64(w);
+}
+
+/**
+ * Scans up to max words for a load, copying each into the arena given as the context and
+ * pairing it with its prefix.
+ */
+static int scanWordBatch(INPUT* ip, void* context, void* out, int max) {
+    const char* words[LOAD_BATCH];
+    size_t lengths[LOAD_BATCH];
+    WORD* items = out;
+    int n = scanWords(ip, words, lengths, max < LOAD_BATCH ? max : LOAD_BATCH);
+    for (int i = 0; i < n; i++) {
+        items[i].prefix = wordPrefix(ip, words[i] - ip->data, lengths[i]);
+        items[i].text = arenaCopy(context, words[i], lengths[i]);
+    }
+    return n;
+}
+
+/**
+ * Runs the scanning thread of a pipelined load, which passes each batch it scans to the
+ * building thread through the queue and closes the queue when scanning stops.
+ *
+ * @param arg the load job
+ * @return null
+ * @timeComplexity O(L) where L is the length of the input
+ */
+static void* scanWorker(void* arg) {
+    LOAD_JOB* job = arg;
+    char* batch = malloc(LOAD_BATCH * job->elemSize);
+    int n;
+    assert(batch != NULL);
+    do {
+        n = job->scan(job->ip, job->context, batch, LOAD_BATCH);
+        queuePushN(job->qp, batch, n);
+    } while (n == LOAD_BATCH);
+    queueClose(job->qp);
+    free(batch);
+    return NULL;
+}
+
+/**
+ * Scans items in batches and adds them to the end of a list, either in turn or, if pipelined,
+ * with the scanning on a second thread while this one adds each batch as it arrives.
+ *
+ * @param ip the input
+ * @param lp the list to add to
+ * @param pipelined whether to scan on a second thread
+ * @param scan the function that scans a batch
+ * @param context the argument passed through to the scan function
+ * @param elemSize the size of each item in bytes
+ * @return the number of items added
+ * @timeComplexity O(L) where L is the length of the input
+ */
+static int loadItems(INPUT* ip, LIST* lp, bool pipelined, int (*scan)(INPUT*, void*, void*, int), void* context,
+                     size_t elemSize) {
+    char* batch = malloc(LOAD_BATCH * elemSize);
+    int n, total = 0;
+    assert(batch != NULL);
+    if (!pipelined) {
+        do {
+            n = scan(ip, context, batch, LOAD_BATCH);
+            addLastN(lp, batch, n);
+            total += n;
+        } while (n == LOAD_BATCH);
+    } else {
+        LOAD_JOB job = {ip, createQueue(elemSize), scan, context, elemSize};
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, scanWorker, &job) != 0)
+            abort();
+        while (true) {
+            n = queuePopN(job.qp, batch, LOAD_BATCH);
+            if (n > 0) {
+                addLastN(lp, batch, n);
+                total += n;
+            } else if (queueFinished(job.qp))
+                break;
+            else
+                sched_yield();
+        }
+        pthread_join(thread, NULL);
+        destroyQueue(job.qp);
+    }
+    free(batch);
+    return total;
+}
+
+/**
+ * Scans non-negative integers as scanInts does and adds them to the end of a list of ints.
+ *
+ * @param ip the input
+ * @param lp the list to add to, created with createListOfSize(sizeof(int))
+ * @param pipelined whether to scan on a second thread while the list is built
+ * @return the number of integers added
+ * @timeComplexity O(L) where L is the length of the input
+ */
+int loadInts(INPUT* ip, LIST* lp, bool pipelined) {
+    assert(ip != NULL && lp != NULL);
+    return loadItems(ip, lp, pipelined, scanIntBatch, NULL, sizeof(int));
+}
+
+/**
+ * Scans every word of the input and adds each to the end of a list of WORD items, with its text
+ * copied into an arena.  The words live until the arena is destroyed.
+ *
+ * @param ip the input
+ * @param lp the list to add to, created with createListOfSize(sizeof(WORD))
+ * @param ap the arena to copy the words into, which only the scanning thread uses during the
+ *        load
+ * @param pipelined whether to scan on a second thread while the list is built
+ * @return the number of words added
+ * @timeComplexity O(L) where L is the length of the input
+ */
+int loadWords(INPUT* ip, LIST* lp, ARENA* ap, bool pipelined) {
+    assert(ip != NULL && lp != NULL && ap != NULL);
+    return loadItems(ip, lp, pipelined, scanWordBatch, ap, sizeof(WORD));
+}
+
+/**
+ * Compares two loaded words as strcmp would compare their text, looking at the text only when
+ * the prefixes are equal and neither word ends within them.
+ *
+ * @param a the first word
+ * @param b the second word
+ * @return a negative number, zero, or a positive number as a is less than, equal to, or greater
+ *         than b
+ * @timeComplexity O(1) unless the words share their first eight bytes; O(n) otherwise
+ */
+int compareWords(const WORD* a, const WORD* b) {
+    if (a->prefix != b->prefix)
+        return a->prefix < b->prefix ? -1 : 1;
+    if ((a->prefix & 0xff) == 0)
+        return 0;
+    return strcmp(a->text + 8, b->text + 8);
+}
+
+/**
+ * Creates an output buffer for the given file descriptor.
+ *
+ * @param fd the file descriptor to write to
+ * @return the new output
+ * @timeComplexity O(1)
+ */
+OUTPUT* openOutput(int fd) {
+    OUTPUT* op = malloc(sizeof(OUTPUT));
+    assert(op != NULL);
+    op->fd = fd;
+    op->failed = false;
+    op->used = 0;
+    return op;
+}
+
+/**
+ * Writes all of the given buffers, retrying after a partial write.
+ *
+ * @param op the output, which is marked as failed on an error
+ * @param iov the buffers, which are updated as they are written
+ * @param count the number of buffers
+ * @timeComplexity O(n) where n is the number of bytes
+ */
+static void writeAll(OUTPUT* op, struct iovec* iov, int count) {
+    while (count > 0 && !op->failed) {
+        ssize_t n = writev(op->fd, iov, count);
+        if (n < 0) {
+            op->failed = true;
+            break;
+        }
+        while (count > 0 && (size_t) n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*) iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+}
+
+/**
+ * Writes out whatever is in the buffer.
+ *
+ * @param op the output
+ * @timeComplexity O(n) where n is the number of bytes buffered
+ */
+static void flushOutput(OUTPUT* op) {
+    struct iovec iov = {op->data, op->used};
+    writeAll(op, &iov, 1);
+    op->used = 0;
+}
+
+/**
+ * Flushes and frees an output.
+ *
+ * @param op the output to close
+ * @return true if everything was written, false if a write failed
+ * @timeComplexity O(n) where n is the number of bytes buffered
+ */
+bool closeOutput(OUTPUT* op) {
+    assert(op != NULL);
+    flushOutput(op);
+    bool ok = !op->failed;
+    free(op);
+    return ok;
+}
+
+/**
+ * Appends bytes to the output.  When they do not fit, the buffer and the bytes are written
+ * together with a single writev.
+ *
+ * @param op the output
+ * @param s the bytes to write
+ * @param n the number of bytes
+ * @timeComplexity O(n)
+ */
+void putBytes(OUTPUT* op, const char* s, size_t n) {
+    assert(op != NULL && s != NULL);
+    if (op->used + n <= OUTPUT_LENGTH) {
+        memcpy(op->data + op->used, s, n);
+        op->used += n;
+    } else {
+        struct iovec iov[2] = {{op->data, op->used}, {(char*) s, n}};
+        writeAll(op, iov, 2);
+        op->used = 0;
+    }
+}
+
+/**
+ * Appends a character to the output.
+ *
+ * @param op the output
+ * @param c the character
+ * @timeComplexity O(1) amortized
+ */
+void putChar(OUTPUT* op, char c) {
+    assert(op != NULL);
+    if (op->used == OUTPUT_LENGTH)
+        flushOutput(op);
+    op->data[op->used++] = c;
+}
+
+/**
+ * Appends an unsigned integer to the output in decimal, formatting two digits at a time from
+ * a table of the hundred pairs.
+ *
+ * @param op the output
+ * @param x the integer
+ * @timeComplexity O(1)
+ */
+void putUnsigned(OUTPUT* op, unsigned long x) {
+    static const char pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    char buf[20];
+    char* p = buf + sizeof(buf);
+    while (x >= 100) {
+        p -= 2;
+        memcpy(p, pairs + x % 100 * 2, 2);
+        x /= 100;
+    }
+    if (x >= 10) {
+        p -= 2;
+        memcpy(p, pairs + x * 2, 2);
+    } else
+        *--p = '0' + x;
+    putBytes(op, p, buf + sizeof(buf) - p);
+}
@@ -0,0 +1,62 @@
+/*
+ * File:	fastio.h
+ *
+ * Description:	This file contains the public function and type
+ *		declarations for reading integers and words from a file
+ *		or the standard input without stdio, and for writing
+ *		them through a large buffer.  The input is mapped when it
+ *		is a regular file and read in whole otherwise, and is
+ *		scanned eight bytes at a time.  The load functions add
+ *		everything scanned to a list in bulk, optionally scanning
+ *		on a second thread while the list is built.  Words are
+ *		loaded as WORD items: a copy of the word in an arena,
+ *		along with its first eight bytes packed big-endian into
+ *		an integer, so that most comparisons of two words need
+ *		only compare their prefixes.
+ */
+
+# ifndef FASTIO_H
+# define FASTIO_H
+
+# include <stddef.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include "list.h"
+# include "arena.h"
+
+typedef struct input INPUT;
+
+typedef struct output OUTPUT;
+
+typedef struct word {
+    uint64_t prefix;
+    const char *text;
+} WORD;
+
+extern INPUT *openInput(const char *path);
+
+extern void closeInput(INPUT *ip);
+
+extern int peekInput(INPUT *ip);
+
+extern int scanInts(INPUT *ip, int *out, int max);
+
+extern int scanWords(INPUT *ip, const char **words, size_t *lengths, int max);
+
+extern int loadInts(INPUT *ip, LIST *lp, bool pipelined);
+
+extern int loadWords(INPUT *ip, LIST *lp, ARENA *ap, bool pipelined);
+
+extern int compareWords(const WORD *a, const WORD *b);
+
+extern OUTPUT *openOutput(int fd);
+
+extern bool closeOutput(OUTPUT *op);
+
+extern void putBytes(OUTPUT *op, const char *s, size_t n);
+
+extern void putChar(OUTPUT *op, char c);
+
+extern void putUnsigned(OUTPUT *op, unsigned long x);
+
+# endif /* FASTIO_H */
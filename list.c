@@ -3,7 +3,7 @@
  * Defines an implementation for an arrayList.
  * This implementation is based on the list.h file provided by the professor
  * The ArrayList Implementation uses a linked list of arrays to store the data.
- * The only missing method is addAtIndex() which was not required in the list.h file.
+ * Items can also be inserted and removed in the middle with addAt() and removeAt().
  *
  * @author Max Blennemann
  * @version 11/29/23
@@ -12,39 +12,168 @@
 #include <assert.h>
 #include <string.h>
 #include <stdbool.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdatomic.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
 #include "list.h"
+#include "listnode.h"
 
 
-typedef struct list {
-    int count;
-    struct node* head;
-} LIST;
+#define DEFAULT_SUBARRAY_LENGTH 2
 
-typedef struct node {
-    void** data;
-    unsigned firstIndex;
-    unsigned count;
-    unsigned capacity;
-    struct node* next;
-    struct node* prev;
-} NODE;
+_Static_assert((DEFAULT_SUBARRAY_LENGTH & (DEFAULT_SUBARRAY_LENGTH - 1)) == 0,
+               "DEFAULT_SUBARRAY_LENGTH must be a power of two");
+#define DEFAULT_INDEX_LENGTH 8
+#define DEFAULT_SPARE_NODES 1
+#define MIDDLE_NODE_MIN 64
+#define DEFAULT_GROWTH_FACTOR 2
+#define DEFAULT_MAX_NODE_BYTES (64 * 1024)
+#define UNBOUNDED_CAPACITY (1u << 31)
 
-#define DEFAULT_SUBARRAY_LENGTH 2
+/*
+ * A pool keeps one free chain per distinct block size.  The classes live in
+ * a small open-addressed table keyed by size, so the handful of sizes a list
+ * uses (the LIST, its index and its nodes) each get a class of their own.
+ */
+#define POOL_CLASSES 64
+#define POOL_ALIGNMENT 16
+
+/*
+ * Blocks of at least MAP_THRESHOLD bytes from listMapAlloc are mapped directly, on 2 MiB
+ * boundaries so that transparent huge pages can back them.  Those of at least MAP_HUGETLB_MIN
+ * bytes are rounded up to whole huge pages, which wastes at most an eighth of the block, and
+ * are taken from the reserved huge pages when there are any.
+ */
+#define MAP_THRESHOLD (256 * 1024)
+#define MAP_HUGETLB_MIN (8 * LIST_HUGE_PAGE_SIZE)
+
+/*
+ * A snapshot file starts with a header, padded to SNAPSHOT_ALIGNMENT, followed by the nodes of
+ * the list laid out exactly as in memory, each on a SNAPSHOT_ALIGNMENT boundary.  Every node
+ * but the last holds a full block of items; the last is only as large as it needs to be.  A
+ * private mapping of the file makes the nodes usable in place once their links are set, and
+ * each page the list writes afterwards is copied on that first write.
+ */
+#define SNAPSHOT_MAGIC "LISTSNAP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define SNAPSHOT_ALIGNMENT 4096
+
+typedef struct snapshotheader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t nodeHeader;               /* sizeof(NODE) when saved */
+    uint32_t blockCapacity;
+    uint64_t elemSize;
+    uint64_t count;
+    uint64_t numNodes;
+} SNAPSHOT_HEADER;
+
+/*
+ * The allocator context of a mapped snapshot.  The mapping lives until every block allocated
+ * through the context has been freed, mapped nodes included, so lists split from a snapshot
+ * list can outlive it.
+ */
+typedef struct snapshot {
+    char* base;
+    size_t length;
+    long blocks;
+} SNAPSHOT;
+
+typedef struct block {
+    struct block* next;
+} BLOCK;
+
+typedef struct listpool {
+    size_t sizes[POOL_CLASSES];
+    BLOCK* free[POOL_CLASSES];
+} LIST_POOL;
+
+/**
+ * The default allocator, which defers to malloc.
+ */
+static void* defaultAlloc(void* ctx, size_t size) {
+    (void) ctx;
+    return malloc(size);
+}
+
+/**
+ * The default deallocator, which defers to free.
+ */
+static void defaultFree(void* ctx, void* ptr, size_t size) {
+    (void) ctx;
+    (void) size;
+    free(ptr);
+}
+
+/**
+ * Allocates memory using the allocator of the list.
+ *
+ * @param lp the list
+ * @param size the number of bytes to allocate
+ * @return the new block
+ * @timeComplexity O(1)
+ */
+static void* listAlloc(LIST* lp, size_t size) {
+    void* p = lp->alloc(lp->ctx, size);
+    assert(p != NULL);
+    return p;
+}
+
+/**
+ * Allocates a buffer for a pass over the whole list.  A list with mapped storage gets a mapped
+ * buffer too, so that the pass is backed by huge pages throughout.
+ *
+ * @param lp the list
+ * @param size the number of bytes to allocate
+ * @return the buffer
+ * @timeComplexity O(1)
+ */
+static void* scratchAlloc(LIST* lp, size_t size) {
+    void* p = lp->alloc == listMapAlloc ? listMapAlloc(NULL, size) : malloc(size);
+    assert(p != NULL);
+    return p;
+}
+
+/**
+ * Frees a buffer from scratchAlloc.
+ *
+ * @param lp the list
+ * @param p the buffer
+ * @param size the size that was passed to scratchAlloc
+ * @timeComplexity O(1)
+ */
+static void scratchFree(LIST* lp, void* p, size_t size) {
+    if (lp->alloc == listMapAlloc)
+        listMapFree(NULL, p, size);
+    else
+        free(p);
+}
 
 /**
  * Makes a new node with the given capacity and next and previous nodes.
- * @param capacity the capacity of the new node
+ * @param lp the list whose allocator to use
+ * @param capacity the capacity of the new node (a power of two)
  * @param next the value you want to be next (can be null)
  * @param prev the value you want to be previous (can be null)
  * @return the new node
  * @tiemComplexity O(1)
  */
-NODE* makeNode(unsigned capacity, NODE* next, NODE* prev) {
-    NODE* np = malloc(sizeof(NODE));
-    assert(np != NULL);
-    np->data = malloc(capacity * sizeof(void*));
-    assert(np->data != NULL);
+NODE* makeNode(LIST* lp, unsigned capacity, NODE* next, NODE* prev) {
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    NODE* np = listAlloc(lp, NODE_SIZE(capacity, lp->elemSize));
+    LIST_STATS_COUNT(lp, nodeAllocs);
     np->capacity = capacity;
+    np->mask = capacity - 1;
     np->next = next;
     np->prev = prev;
     np->firstIndex = 0;
@@ -53,214 +182,3604 @@ NODE* makeNode(unsigned capacity, NODE* next, NODE* prev) {
 }
 
 /**
- * Creates a new list and returns a pointer to it. Defualt length is 3 * DEFAULT_SUBARRAY_LENGTH (6)
+ * Frees a node and its data.
+ *
+ * @param lp the list that owned the node
+ * @param np the node to free
+ * @timeComplexity O(1)
+ */
+static void freeNode(LIST* lp, NODE* np) {
+    lp->slots -= np->capacity;
+    LIST_STATS_COUNT(lp, nodeFrees);
+    lp->release(lp->ctx, np, NODE_SIZE(np->capacity, lp->elemSize));
+}
+
+/**
+ * Returns the largest power of two number of items of the given size that fit in the given
+ * number of bytes, but no less than DEFAULT_SUBARRAY_LENGTH.  Zero bytes means no limit.
+ *
+ * @param elemSize the size of each item in bytes
+ * @param maxBytes the largest node data size in bytes, or zero
+ * @return the maximum node capacity
+ * @timeComplexity O(log(maxBytes))
+ */
+static unsigned maxCapacityFor(size_t elemSize, size_t maxBytes) {
+    if (maxBytes == 0)
+        return UNBOUNDED_CAPACITY;
+    unsigned capacity = DEFAULT_SUBARRAY_LENGTH;
+    while (capacity < UNBOUNDED_CAPACITY && (size_t) capacity * 2 * elemSize <= maxBytes)
+        capacity *= 2;
+    return capacity;
+}
+
+/**
+ * Creates a new list of items of the given size, stored by value, whose memory, including the
+ * list itself, is obtained from the given allocator.  The free callback is passed the size
+ * that was originally requested.
  *
+ * @param elemSize the size of each item in bytes
+ * @param alloc the function used to allocate memory
+ * @param release the function used to free memory
+ * @param ctx the context passed to both functions
  * @return the new list
  * @timeComplexity O(1)
  */
-LIST* createList() {
-    LIST* lp = malloc(sizeof(LIST));
+LIST* createListOfSizeWithAllocator(size_t elemSize, LIST_ALLOC alloc, LIST_FREE release, void* ctx) {
+    assert(elemSize > 0);
+    assert(alloc != NULL && release != NULL);
+    LIST* lp = alloc(ctx, sizeof(LIST));
     assert(lp != NULL);
+    lp->elemSize = elemSize;
+    lp->alloc = alloc;
+    lp->release = release;
+    lp->ctx = ctx;
     lp->count = 0;
-    lp->head = makeNode(DEFAULT_SUBARRAY_LENGTH, NULL, NULL);
-    lp->head->next = makeNode(DEFAULT_SUBARRAY_LENGTH * 2, lp->head, lp->head);
-    lp->head->prev = lp->head->next;
+#ifdef LIST_STATS
+    memset(&lp->stats, 0, sizeof(lp->stats));
+    lp->stats.counted = true;
+#endif
+    lp->initialCapacity = DEFAULT_SUBARRAY_LENGTH;
+    lp->growthFactor = DEFAULT_GROWTH_FACTOR;
+    lp->maxCapacity = maxCapacityFor(elemSize, DEFAULT_MAX_NODE_BYTES);
+    lp->head = makeNode(lp, DEFAULT_SUBARRAY_LENGTH, NULL, NULL);
+    lp->head->next = lp->head;
+    lp->head->prev = lp->head;
+    lp->slots = DEFAULT_SUBARRAY_LENGTH;
+    lp->spares = NULL;
+    lp->numSpares = 0;
+    lp->trimPolicy = LIST_TRIM_SPARE;
+    lp->trimParam = DEFAULT_SPARE_NODES;
+    lp->maxNodes = DEFAULT_INDEX_LENGTH;
+    lp->entries = listAlloc(lp, lp->maxNodes * sizeof(ENTRY));
+    lp->index = lp->entries + lp->maxNodes / 2;
+    lp->numNodes = 1;
+    lp->index[0].start = 0;
+    lp->index[0].np = lp->head;
     return lp;
 }
 
 /**
- * Destroys the list and frees all memory associated with it.
+ * Creates a new list of void pointers whose memory is obtained from the given allocator.
  *
- * @param lp the list to destroy
- * @timeComplexity O(N)
+ * @param alloc the function used to allocate memory
+ * @param release the function used to free memory
+ * @param ctx the context passed to both functions
+ * @return the new list
+ * @timeComplexity O(1)
  */
-void destroyList(LIST* lp) {
-    assert(lp != NULL);
-    NODE* current = lp->head;
-    do {
-        NODE* next = current->next;
-        free(current->data);
-        free(current);
-        current = next;
-    } while (current != lp->head);
-    free(lp);
+LIST* createListWithAllocator(LIST_ALLOC alloc, LIST_FREE release, void* ctx) {
+    return createListOfSizeWithAllocator(sizeof(void*), alloc, release, ctx);
 }
 
-
 /**
- * Returns the number of items in the list.
+ * Creates a new list of items of the given size, which are copied in and out by value.
  *
- * @param lp the list to get the number of items from
- * @return the number of items in the list
+ * @param elemSize the size of each item in bytes
+ * @return the new list
  * @timeComplexity O(1)
  */
-int numItems(LIST* lp) {
-    assert(lp != NULL);
-    return lp->count;
+LIST* createListOfSize(size_t elemSize) {
+    return createListOfSizeWithAllocator(elemSize, defaultAlloc, defaultFree, NULL);
 }
 
 /**
- * Adds an item to the front of the list.
+ * Creates a new list and returns a pointer to it. The list starts with a single node of
+ * DEFAULT_SUBARRAY_LENGTH slots shared by both ends.
  *
- * @param lp the list to add the item to
- * @param item the item to add (cant be null)
+ * @return the new list
  * @timeComplexity O(1)
  */
-void addFirst(LIST* lp, void* item) {
-    assert(lp != NULL);
-    assert(item != NULL);
-    if (lp->head->capacity == lp->head->count) {
-        NODE* np = makeNode(lp->head->capacity * 2, lp->head, lp->head->prev);
-        lp->head->prev->next = np;
-        lp->head->prev = np;
-        lp->head = np;
+LIST* createList() {
+    return createListOfSizeWithAllocator(sizeof(void*), defaultAlloc, defaultFree, NULL);
+}
+
+/**
+ * Creates a new list with storage preallocated for the given number of items, so that adding
+ * them allocates nothing.
+ *
+ * @param n the number of items to make room for
+ * @return the new list
+ * @timeComplexity O(n / C) where C is the maximum node capacity
+ */
+LIST* createListWithCapacity(int n) {
+    LIST* lp = createList();
+    listReserve(lp, n);
+    return lp;
+}
+
+/**
+ * Inserts a node into the index at the given position, recentering or growing the index
+ * buffer when the side being inserted on has no room left.
+ *
+ * @param lp the list whose index to update
+ * @param pos the position of the node in list order
+ * @param np the node to insert
+ * @param start the absolute position of the first element of the node
+ * @timeComplexity O(1) amortized at either end; O(M) in the middle where M is the number of nodes
+ */
+static void indexInsert(LIST* lp, int pos, NODE* np, long start) {
+    int front = lp->index - lp->entries;
+    int back = lp->maxNodes - front - lp->numNodes;
+    if ((pos == 0 && front == 0) || (pos > 0 && back == 0)) {
+        if (lp->numNodes * 2 >= lp->maxNodes) {
+            ENTRY* entries = listAlloc(lp, lp->maxNodes * 2 * sizeof(ENTRY));
+            memcpy(entries + (lp->maxNodes * 2 - lp->numNodes) / 2, lp->index, lp->numNodes * sizeof(ENTRY));
+            lp->release(lp->ctx, lp->entries, lp->maxNodes * sizeof(ENTRY));
+            lp->maxNodes *= 2;
+            lp->entries = entries;
+        } else
+            memmove(lp->entries + (lp->maxNodes - lp->numNodes) / 2, lp->index, lp->numNodes * sizeof(ENTRY));
+        lp->index = lp->entries + (lp->maxNodes - lp->numNodes) / 2;
     }
-    if (lp->head->firstIndex == 0)
-        lp->head->firstIndex += lp->head->capacity;
-    lp->head->firstIndex = (lp->head->firstIndex - 1) % lp->head->capacity;
-    lp->head->count++;
-    lp->head->data[lp->head->firstIndex] = item;
-    lp->count++;
+    if (pos == 0) {
+        lp->index--;
+    } else
+        memmove(lp->index + pos + 1, lp->index + pos, (lp->numNodes - pos) * sizeof(ENTRY));
+    lp->index[pos].start = start;
+    lp->index[pos].np = np;
+    lp->numNodes++;
 }
 
 /**
- * Adds an item to the end of the list.
+ * Removes the node at the given position from the index.
  *
- * @param lp the list to add the item to
- * @param item the item to add (cant be null)
+ * @param lp the list whose index to update
+ * @param pos the position of the node in list order
+ * @timeComplexity O(1) at either end; O(M) in the middle where M is the number of nodes
+ */
+static void indexRemove(LIST* lp, int pos) {
+    if (pos == 0)
+        lp->index++;
+    else
+        memmove(lp->index + pos, lp->index + pos + 1, (lp->numNodes - pos - 1) * sizeof(ENTRY));
+    lp->numNodes--;
+}
+
+/**
+ * Grows the index, if necessary, so that the given number of nodes can be added at either end
+ * without moving it again.
+ *
+ * @param lp the list whose index to grow
+ * @param extra the number of nodes to make room for on each side
+ * @timeComplexity O(M) where M is the number of nodes
+ */
+static void indexReserve(LIST* lp, int extra) {
+    int front = lp->index - lp->entries;
+    int back = lp->maxNodes - front - lp->numNodes;
+    if (front >= extra && back >= extra)
+        return;
+    int maxNodes = lp->maxNodes;
+    while (maxNodes < lp->numNodes + 2 * extra)
+        maxNodes *= 2;
+    ENTRY* entries = listAlloc(lp, maxNodes * sizeof(ENTRY));
+    memcpy(entries + (maxNodes - lp->numNodes) / 2, lp->index, lp->numNodes * sizeof(ENTRY));
+    lp->release(lp->ctx, lp->entries, lp->maxNodes * sizeof(ENTRY));
+    lp->maxNodes = maxNodes;
+    lp->entries = entries;
+    lp->index = entries + (maxNodes - lp->numNodes) / 2;
+}
+
+/**
+ * Finds the node holding the given index using the node index.
+ *
+ * @param lp the list to search
+ * @param index the logical index of the item
+ * @param offset set to the offset of the item within the node
+ * @return the position in the index of the node containing the item
+ * @timeComplexity O(log(M)) where M is the number of nodes
+ */
+static int findEntry(LIST* lp, int index, unsigned* offset) {
+    long pos = lp->index[0].start + index;
+    int lo = 0, hi = lp->numNodes - 1;
+#ifdef LIST_STATS
+    int steps = 0;
+#endif
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (lp->index[mid].start <= pos)
+            lo = mid;
+        else
+            hi = mid - 1;
+#ifdef LIST_STATS
+        steps++;
+#endif
+    }
+#ifdef LIST_STATS
+    LIST_STATS_BUMP(lp->stats.walks[steps < LIST_STATS_BUCKETS ? steps : LIST_STATS_BUCKETS - 1]);
+#endif
+    *offset = pos - lp->index[lo].start;
+    return lo;
+}
+
+/**
+ * Returns the address of the item at the given offset of a node.  The size is passed in so
+ * that callers that know it at compile time get a constant multiplication.
+ *
+ * @param np the node
+ * @param offset the logical offset of the item within the node
+ * @param size the size of each item in bytes
+ * @return the address of the item
  * @timeComplexity O(1)
  */
-void addLast(LIST* lp, void* item) {
-    assert(lp != NULL);
-    assert(item != NULL);
-    NODE* lastNode = lp->head->prev;
-    if (lastNode->count == lastNode->capacity) {
-        NODE* newNode = makeNode(lastNode->capacity * 2, lp->head, lastNode);
-        lastNode->next = newNode;
-        lp->head->prev = newNode;
-        lastNode = newNode;
+static inline char* slotAt(NODE* np, unsigned offset, size_t size) {
+    return np->data + (size_t) ((np->firstIndex + offset) & np->mask) * size;
+}
+
+/**
+ * Copies items into consecutive slots of a node's ring buffer, in at most two runs.
+ *
+ * @param lp the list owning the node
+ * @param np the node to write
+ * @param offset the logical offset of the first slot
+ * @param items the items to copy
+ * @param n the number of items
+ * @timeComplexity O(n)
+ */
+static void ringWrite(LIST* lp, NODE* np, unsigned offset, const void* items, unsigned n) {
+    unsigned first = (np->firstIndex + offset) & np->mask;
+    unsigned run = np->capacity - first < n ? np->capacity - first : n;
+    memcpy(np->data + (size_t) first * lp->elemSize, items, (size_t) run * lp->elemSize);
+    memcpy(np->data, (const char*) items + (size_t) run * lp->elemSize, (size_t) (n - run) * lp->elemSize);
+}
+
+/**
+ * Copies items out of consecutive slots of a node's ring buffer, in at most two runs.
+ *
+ * @param lp the list owning the node
+ * @param np the node to read
+ * @param offset the logical offset of the first slot
+ * @param items the destination
+ * @param n the number of items
+ * @timeComplexity O(n)
+ */
+static void ringRead(LIST* lp, NODE* np, unsigned offset, void* items, unsigned n) {
+    unsigned first = (np->firstIndex + offset) & np->mask;
+    unsigned run = np->capacity - first < n ? np->capacity - first : n;
+    memcpy(items, np->data + (size_t) first * lp->elemSize, (size_t) run * lp->elemSize);
+    memcpy((char*) items + (size_t) run * lp->elemSize, np->data, (size_t) (n - run) * lp->elemSize);
+}
+
+/**
+ * Returns the capacity of a node linked next to one of the given capacity: the growth factor
+ * times as large, doubled further until it holds the given number of items, but never more
+ * than the maximum node capacity of the list.
+ *
+ * @param lp the list
+ * @param capacity the capacity of the neighboring node
+ * @param n the number of items the new node should hold
+ * @return the new capacity
+ * @timeComplexity O(log(n))
+ */
+static unsigned growCapacity(LIST* lp, unsigned capacity, unsigned n) {
+    if (capacity >= lp->maxCapacity / lp->growthFactor)
+        return lp->maxCapacity;
+    capacity *= lp->growthFactor;
+    while (capacity < n && capacity < lp->maxCapacity)
+        capacity *= 2;
+    return capacity;
+}
+
+/**
+ * Returns the smallest power of two that holds the given number of items, but no less than
+ * DEFAULT_SUBARRAY_LENGTH.
+ *
+ * @param n the number of items
+ * @return the capacity
+ * @timeComplexity O(log(n))
+ */
+static unsigned fitCapacity(unsigned n) {
+    unsigned capacity = DEFAULT_SUBARRAY_LENGTH;
+    while (capacity < n)
+        capacity *= 2;
+    return capacity;
+}
+
+/**
+ * Rebuilds the index by walking the node chain from the head, after nodes have been
+ * relinked wholesale.  Positions are renumbered from zero.
+ *
+ * @param lp the list whose index to rebuild
+ * @timeComplexity O(M) where M is the number of nodes
+ */
+static void rebuildIndex(LIST* lp) {
+    int numNodes = 0;
+    NODE* np = lp->head;
+    do {
+        numNodes++;
+        np = np->next;
+    } while (np != lp->head);
+    if (numNodes * 2 > lp->maxNodes) {
+        int maxNodes = lp->maxNodes;
+        while (numNodes * 2 > maxNodes)
+            maxNodes *= 2;
+        ENTRY* entries = listAlloc(lp, maxNodes * sizeof(ENTRY));
+        lp->release(lp->ctx, lp->entries, lp->maxNodes * sizeof(ENTRY));
+        lp->entries = entries;
+        lp->maxNodes = maxNodes;
+    }
+    lp->index = lp->entries + (lp->maxNodes - numNodes) / 2;
+    lp->numNodes = numNodes;
+    long start = 0;
+    for (int i = 0; i < numNodes; i++, np = np->next) {
+        lp->index[i].start = start;
+        lp->index[i].np = np;
+        start += np->count;
     }
-    unsigned insertIndex = (lastNode->firstIndex + lastNode->count) % lastNode->capacity;
-    lastNode->data[insertIndex] = item;
-    lastNode->count++;
-    lp->count++;
 }
 
+/**
+ * Frees every spare node held by the list.
+ *
+ * @param lp the list whose spares to release
+ * @timeComplexity O(S) where S is the number of spare nodes
+ */
+static void releaseSpares(LIST* lp) {
+    while (lp->spares != NULL) {
+        NODE* np = lp->spares;
+        lp->spares = np->next;
+        freeNode(lp, np);
+    }
+    lp->numSpares = 0;
+}
 
 /**
- * Removes the item at the front of the list.
+ * Gets a node of about the given capacity, reusing a spare node when one is at least half as
+ * large as requested and holds at least the given minimum, and allocating a new one otherwise.
  *
- * @param lp the list to add the item to
- * @param item the item to add (cant be null)
- * @timeComplexity O(1) usually; O(log(N)) where N is the number of elements removed from the front of the array worst case
+ * @param lp the list that will own the node
+ * @param capacity the requested capacity
+ * @param minimum the number of items the node must be able to hold
+ * @param next the next node
+ * @param prev the previous node
+ * @return the empty node
+ * @timeComplexity O(S) where S is the number of spare nodes
  */
-void* removeFirst(LIST* lp) {
-    assert(lp != NULL);
-    assert(lp->count > 0);
-    NODE* front = lp->head;
-    while (front->count == 0) {
-        front = front->next;
+static NODE* obtainNode(LIST* lp, unsigned capacity, unsigned minimum, NODE* next, NODE* prev) {
+    NODE** npp = &lp->spares;
+    while (*npp != NULL && ((*npp)->capacity < capacity / 2 || (*npp)->capacity < minimum))
+        npp = &(*npp)->next;
+    NODE* np = *npp;
+    if (np != NULL) {
+        *npp = np->next;
+        lp->numSpares--;
+        np->firstIndex = 0;
+        np->next = next;
+        np->prev = prev;
+    } else {
+        np = makeNode(lp, capacity, next, prev);
+        lp->slots += capacity;
     }
-    void* item = front->data[front->firstIndex];
-    front->firstIndex = (front->firstIndex + 1) % front->capacity;
-    front->count--;
-    lp->count--;
-    return item;
+    return np;
 }
 
 /**
- * Removes the last element from the array.
+ * Returns the page size of the mapping that listMapAlloc makes for a block of the given size:
+ * a huge page for blocks that may be taken from the reserved huge pages, whose mappings can
+ * only be advised on huge page boundaries, and a base page otherwise.
  *
- * @param lp the list to remove the last element from
- * @return the removed element
- * @timeComplexity O(1) usually; O(log(N)) where N is the number of elements removed from the end of the array worst case
+ * @param size the size of the block, at least MAP_THRESHOLD
+ * @return the page size
+ * @timeComplexity O(1)
  */
-void* removeLast(LIST* lp) {
-    assert(lp != NULL);
-    assert(lp->count > 0);
-    NODE* a = lp->head->prev;
-    while (a->count == 0) {
-        a = a->prev;
+static size_t mapPageSize(size_t size) {
+    return size >= MAP_HUGETLB_MIN ? LIST_HUGE_PAGE_SIZE : (size_t) sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * Returns the length of the mapping that listMapAlloc makes for a block of the given size.
+ *
+ * @param size the size of the block, at least MAP_THRESHOLD
+ * @return the length of the mapping
+ * @timeComplexity O(1)
+ */
+static size_t mapLength(size_t size) {
+    size_t unit = mapPageSize(size);
+    return (size + unit - 1) / unit * unit;
+}
+
+/**
+ * Drops the pages of a mapped node, other than the one holding its header, so that they no
+ * longer count against the resident size.  They read back as zeros when next touched.  The
+ * pages are those of the mapping, so a node on huge pages keeps its whole first huge page.
+ *
+ * @param np the node
+ * @param size the size of the node in bytes
+ * @return true if the pages were dropped; false if the node is not mapped or the kernel
+ *         refused, in which case the node is left as it was
+ * @timeComplexity O(P) where P is the number of pages
+ */
+static bool discardPages(NODE* np, size_t size) {
+    if (size < MAP_THRESHOLD)
+        return false;
+    size_t page = mapPageSize(size), length = mapLength(size);
+    if (length <= page)
+        return false;
+    return madvise((char*) np + page, length - page, MADV_DONTNEED) == 0;
+}
+
+/**
+ * Disposes of a node that has been unlinked from the list, either keeping it as a spare or
+ * freeing it, according to the trim policy of the list.  The pages of a mapped spare are
+ * handed back to the system until the node is reused.
+ *
+ * @param lp the list that owned the node
+ * @param np the drained node
+ * @timeComplexity O(1) usually; O(S) when the hysteresis policy releases the spares
+ */
+static void retireNode(LIST* lp, NODE* np) {
+    if (lp->trimPolicy == LIST_TRIM_EAGER ||
+        (lp->trimPolicy == LIST_TRIM_SPARE && lp->numSpares >= lp->trimParam)) {
+        freeNode(lp, np);
+        return;
     }
-    void* item = a->data[(a->firstIndex + a->count - 1) % a->capacity];
-    a->count--;
+    if (lp->alloc == listMapAlloc)
+        discardPages(np, NODE_SIZE(np->capacity, lp->elemSize));
+    np->next = lp->spares;
+    lp->spares = np;
+    lp->numSpares++;
+    if (lp->trimPolicy == LIST_TRIM_HYSTERESIS && (long) lp->count * lp->trimParam < lp->slots)
+        releaseSpares(lp);
+}
+
+/**
+ * Unlinks a drained node from the list.  The list must have another node.
+ *
+ * @param lp the list to trim
+ * @param pos the position of the node in the index
+ * @timeComplexity O(1) amortized at either end; O(M) in the middle where M is the number of nodes
+ */
+void listReleaseNode(LIST* lp, int pos) {
+    NODE* np = lp->index[pos].np;
+    np->prev->next = np->next;
+    np->next->prev = np->prev;
+    if (lp->head == np)
+        lp->head = np->next;
+    indexRemove(lp, pos);
+    retireNode(lp, np);
+}
+
+/**
+ * Removes the item at the given offset of a node by shifting whichever side of the node is
+ * smaller, then fixes the index from whichever end of the list is nearer.
+ *
+ * @param lp the list to modify
+ * @param pos the position of the node in the index
+ * @param offset the offset of the item within the node
+ * @param out where to copy the removed item (can be null)
+ * @timeComplexity O(C + M) where C is the node capacity and M is the number of nodes
+ */
+static void removeInNode(LIST* lp, int pos, unsigned offset, void* out) {
+    NODE* np = lp->index[pos].np;
+    size_t size = lp->elemSize;
+    if (out != NULL)
+        memcpy(out, slotAt(np, offset, size), size);
+    if (offset < np->count / 2) {
+        for (unsigned i = offset; i > 0; i--)
+            memcpy(slotAt(np, i, size), slotAt(np, i - 1, size), size);
+        np->firstIndex = (np->firstIndex + 1) & np->mask;
+    } else {
+        for (unsigned i = offset; i + 1 < np->count; i++)
+            memcpy(slotAt(np, i, size), slotAt(np, i + 1, size), size);
+    }
+    np->count--;
     lp->count--;
-    return item;
+    if (pos < lp->numNodes / 2) {
+        for (int i = 0; i <= pos; i++)
+            lp->index[i].start++;
+    } else {
+        for (int i = pos + 1; i < lp->numNodes; i++)
+            lp->index[i].start--;
+    }
+    if (np->count == 0 && lp->numNodes > 1)
+        listReleaseNode(lp, pos);
 }
 
 /**
- * Returns the first element in the list.
+ * Splits a node in two at the given offset, copying whichever part is smaller into a new
+ * node, so that a node boundary falls at that offset.
  *
- * @param lp the list to get the first element from
- * @return the first element
- * @timeComplexity O(1) usually; O(log(N)) where N is the number of elements removed from the front of the array worst case
+ * @param lp the list to modify
+ * @param pos the position of the node in the index
+ * @param offset the offset within the node, strictly between zero and its count
+ * @timeComplexity O(C + M) where C is the node capacity and M is the number of nodes
  */
-void* getFirst(LIST* lp) {
-    printf("getFirst\n");
-    assert(lp != NULL);
-    assert(lp->count > 0);
-    NODE* a = lp->head;
-    while (a->count == 0) {
-        a = a->next;
+static void splitNode(LIST* lp, int pos, unsigned offset) {
+    NODE* np = lp->index[pos].np;
+    assert(offset > 0 && offset < np->count);
+    if (offset <= np->count - offset) {
+        NODE* front = obtainNode(lp, fitCapacity(offset), offset, np, np->prev);
+        ringRead(lp, np, 0, front->data, offset);
+        front->count = offset;
+        np->prev->next = front;
+        np->prev = front;
+        if (lp->head == np)
+            lp->head = front;
+        np->firstIndex = (np->firstIndex + offset) & np->mask;
+        np->count -= offset;
+        indexInsert(lp, pos, front, lp->index[pos].start);
+        lp->index[pos + 1].start += offset;
+    } else {
+        NODE* back = obtainNode(lp, fitCapacity(np->count - offset), np->count - offset, np->next, np);
+        ringRead(lp, np, offset, back->data, np->count - offset);
+        back->count = np->count - offset;
+        np->next->prev = back;
+        np->next = back;
+        np->count = offset;
+        indexInsert(lp, pos + 1, back, lp->index[pos].start + offset);
     }
-    return a->data[lp->head->firstIndex];
 }
 
 /**
- * Returns the last element in the list.
+ * Returns the largest number of items a node may hold before an insertion or removal in the
+ * middle of the list splits it: a power of two near twice the square root of the number of
+ * items, but no less than MIDDLE_NODE_MIN.  Keeping middle nodes this small bounds both the
+ * shifting within a node and the number of index entries to fix at O(sqrt(N)).
  *
- * @param lp the list to get the last element from
- * @return the last element
- * @timeComplexity O(1) usually; O(log(N)) where N is the number of elements removed from the end of the array worst case
+ * @param lp the list
+ * @return the limit
+ * @timeComplexity O(log(N))
  */
-void* getLast(LIST* lp) {
-    assert(lp != NULL);
-    assert(lp->count > 0);
-    NODE* a = lp->head->prev;
-    while (a->count == 0) {
-        a = a->prev;
+static unsigned middleNodeLimit(LIST* lp) {
+    unsigned limit = MIDDLE_NODE_MIN;
+    while ((long) limit * limit < 4L * lp->count)
+        limit *= 2;
+    return limit;
+}
+
+/**
+ * Replaces a full node with a larger one, as the growth policy allows, holding the same items.
+ *
+ * @param lp the list to modify
+ * @param pos the position of the node in the index
+ * @timeComplexity O(C) where C is the node capacity
+ */
+static void growNode(LIST* lp, int pos) {
+    NODE* np = lp->index[pos].np;
+    unsigned capacity = growCapacity(lp, np->capacity, np->count + 1);
+    NODE* bigger = obtainNode(lp, capacity, np->count + 1, np->next, np->prev);
+    ringRead(lp, np, 0, bigger->data, np->count);
+    bigger->count = np->count;
+    if (np->next == np) {
+        bigger->next = bigger;
+        bigger->prev = bigger;
+    } else {
+        np->prev->next = bigger;
+        np->next->prev = bigger;
     }
-    return a->data[(a->firstIndex + a->count - 1) % a->capacity];
+    if (lp->head == np)
+        lp->head = bigger;
+    lp->index[pos].np = bigger;
+    retireNode(lp, np);
 }
 
 /**
- * Returns the item at the given index.
+ * Inserts an item at the given offset of a node that has room for it by shifting whichever
+ * side of the node is smaller, then fixes the index from whichever end of the list is nearer.
  *
- * @param lp the list to access
- * @param index the index of access
- * @return the item at the given index
- * @timeComplexity O(N) where N is the given index
+ * @param lp the list to modify
+ * @param pos the position of the node in the index
+ * @param offset the offset the item will have, from zero to the count of the node
+ * @param elem the address of the item
+ * @timeComplexity O(C + M) where C is the node capacity and M is the number of nodes
  */
-void* getItem(LIST* lp, int index) {
-    assert(lp != NULL);
-    assert(index >= 0 && index < lp->count);
-    NODE* np = lp->head;
-    while (index >= np->count) {
-        index -= np->count;
-        np = np->next;
+static void insertInNode(LIST* lp, int pos, unsigned offset, const void* elem) {
+    NODE* np = lp->index[pos].np;
+    size_t size = lp->elemSize;
+    assert(np->count < np->capacity && offset <= np->count);
+    if (offset < np->count / 2) {
+        np->firstIndex = (np->firstIndex - 1) & np->mask;
+        for (unsigned i = 0; i < offset; i++)
+            memcpy(slotAt(np, i, size), slotAt(np, i + 1, size), size);
+    } else {
+        for (unsigned i = np->count; i > offset; i--)
+            memcpy(slotAt(np, i, size), slotAt(np, i - 1, size), size);
+    }
+    memcpy(slotAt(np, offset, size), elem, size);
+    np->count++;
+    lp->count++;
+    if (pos < lp->numNodes / 2) {
+        for (int i = 0; i <= pos; i++)
+            lp->index[i].start--;
+    } else {
+        for (int i = pos + 1; i < lp->numNodes; i++)
+            lp->index[i].start++;
     }
-    return np->data[(np->firstIndex + index) % np->capacity];
 }
 
 /**
- * Sets the item at the given index to the given item.
+ * Merges a node with the one after it when either has room for the items of both, moving
+ * the items of the smaller node into the larger.
  *
  * @param lp the list to modify
- * @param index the index to edit
- * @param item the new value of the item
- * @timeComplexity O(N) where N is the given index
+ * @param pos the position of the first of the two nodes in the index
+ * @return true if the nodes were merged
+ * @timeComplexity O(C + M) where C is the node capacity and M is the number of nodes
  */
-void setItem(LIST* lp, int index, void* item) {
-    assert(lp != NULL);
-    assert(index >= 0 && index < lp->count);
-    NODE* np = lp->head;
-    while (index >= np->count) {
-        index -= np->count;
-        np = np->next;
+static bool mergeNodes(LIST* lp, int pos) {
+    NODE* a = lp->index[pos].np;
+    NODE* b = lp->index[pos + 1].np;
+    size_t size = lp->elemSize;
+    unsigned total = a->count + b->count;
+    if (a->count >= b->count && total <= a->capacity) {
+        for (unsigned i = 0; i < b->count; i++)
+            memcpy(slotAt(a, a->count + i, size), slotAt(b, i, size), size);
+        a->count = total;
+        b->count = 0;
+        listReleaseNode(lp, pos + 1);
+    } else if (total <= b->capacity) {
+        b->firstIndex = (b->firstIndex - a->count) & b->mask;
+        for (unsigned i = 0; i < a->count; i++)
+            memcpy(slotAt(b, i, size), slotAt(a, i, size), size);
+        b->count = total;
+        lp->index[pos + 1].start = lp->index[pos].start;
+        a->count = 0;
+        listReleaseNode(lp, pos);
+    } else
+        return false;
+    return true;
+}
+
+/**
+ * Finds the node and offset at which an item can be inserted so that it gets the given index,
+ * first splitting the node in half while it is over the middle node limit and growing it if
+ * it is full.  An insertion at the start of a node goes at the end of the previous node
+ * instead when that one has room.
+ *
+ * @param lp the list to modify
+ * @param index the index the item will have, strictly between zero and the count of the list
+ * @param offset set to the offset the item will have within the node
+ * @return the position of the node in the index
+ * @timeComplexity O(C + M) where C is the node capacity and M is the number of nodes
+ */
+static int prepareInsert(LIST* lp, int index, unsigned* offset) {
+    unsigned limit = middleNodeLimit(lp);
+    if (limit > lp->maxCapacity)
+        limit = lp->maxCapacity;
+    while (true) {
+        int pos = findEntry(lp, index, offset);
+        NODE* np = lp->index[pos].np;
+        if (*offset == 0 && pos > 0) {
+            NODE* prev = lp->index[pos - 1].np;
+            if (prev->count < prev->capacity && prev->count < limit) {
+                *offset = prev->count;
+                return pos - 1;
+            }
+        }
+        if (np->count >= limit) {
+            splitNode(lp, pos, np->count / 2);
+            continue;
+        }
+        if (np->count == np->capacity)
+            growNode(lp, pos);
+        return pos;
     }
-    np->data[(np->firstIndex + index) % np->capacity] = item;
 }
 
+/**
+ * Destroys the list and frees all memory associated with it.
+ *
+ * @param lp the list to destroy
+ * @timeComplexity O(N)
+ */
+void destroyList(LIST* lp) {
+    assert(lp != NULL);
+    NODE* current = lp->head;
+    do {
+        NODE* next = current->next;
+        freeNode(lp, current);
+        current = next;
+    } while (current != lp->head);
+    releaseSpares(lp);
+    lp->release(lp->ctx, lp->entries, lp->maxNodes * sizeof(ENTRY));
+    lp->release(lp->ctx, lp, sizeof(LIST));
+}
+
+
+/**
+ * Returns the number of items in the list.
+ *
+ * @param lp the list to get the number of items from
+ * @return the number of items in the list
+ * @timeComplexity O(1)
+ */
+int numItems(LIST* lp) {
+    assert(lp != NULL);
+    return lp->count;
+}
+
+/**
+ * Links a new node in front of the full first node.
+ *
+ * @param lp the list to grow
+ * @timeComplexity O(1) amortized
+ */
+void listGrowFirst(LIST* lp) {
+    NODE* np = obtainNode(lp, growCapacity(lp, lp->head->capacity, 1), 1, lp->head, lp->head->prev);
+    lp->head->prev->next = np;
+    lp->head->prev = np;
+    lp->head = np;
+    indexInsert(lp, 0, np, lp->index[0].start);
+}
+
+/**
+ * Links a new node after the full last node.
+ *
+ * @param lp the list to grow
+ * @timeComplexity O(1) amortized
+ */
+void listGrowLast(LIST* lp) {
+    NODE* lastNode = lp->head->prev;
+    NODE* newNode = obtainNode(lp, growCapacity(lp, lastNode->capacity, 1), 1, lp->head, lastNode);
+    lastNode->next = newNode;
+    lp->head->prev = newNode;
+    ENTRY* last = &lp->index[lp->numNodes - 1];
+    indexInsert(lp, lp->numNodes, newNode, last->start + last->np->count);
+}
+
+/**
+ * Claims a slot in front of the first item.
+ *
+ * @param lp the list to add to
+ * @param size the size of each item in bytes
+ * @return the address of the new first slot
+ * @timeComplexity O(1) amortized
+ */
+static inline char* pushFirst(LIST* lp, size_t size) {
+    LIST_STATS_START();
+    if (lp->head->capacity == lp->head->count)
+        listGrowFirst(lp);
+    NODE* np = lp->head;
+    np->firstIndex = (np->firstIndex - 1) & np->mask;
+    np->count++;
+    lp->index[0].start--;
+    lp->count++;
+    LIST_STATS_END(lp, pushes);
+    return np->data + (size_t) np->firstIndex * size;
+}
+
+/**
+ * Claims a slot after the last item.
+ *
+ * @param lp the list to add to
+ * @param size the size of each item in bytes
+ * @return the address of the new last slot
+ * @timeComplexity O(1) amortized
+ */
+static inline char* pushLast(LIST* lp, size_t size) {
+    LIST_STATS_START();
+    if (lp->head->prev->count == lp->head->prev->capacity)
+        listGrowLast(lp);
+    NODE* lastNode = lp->head->prev;
+    char* slot = slotAt(lastNode, lastNode->count, size);
+    lastNode->count++;
+    lp->count++;
+    LIST_STATS_END(lp, pushes);
+    return slot;
+}
+
+/**
+ * Removes the first item, copying it out before its node can be released.
+ *
+ * @param lp the list to remove from
+ * @param out where to copy the item (can be null)
+ * @param size the size of each item in bytes
+ * @timeComplexity O(1) amortized
+ */
+static inline void popFirst(LIST* lp, void* out, size_t size) {
+    LIST_STATS_START();
+    NODE* front = lp->head;
+    if (out != NULL)
+        memcpy(out, front->data + (size_t) front->firstIndex * size, size);
+    front->firstIndex = (front->firstIndex + 1) & front->mask;
+    front->count--;
+    lp->index[0].start++;
+    lp->count--;
+    if (front->count == 0 && front->next != front)
+        listReleaseNode(lp, 0);
+    LIST_STATS_END(lp, pops);
+}
+
+/**
+ * Removes the last item, copying it out before its node can be released.
+ *
+ * @param lp the list to remove from
+ * @param out where to copy the item (can be null)
+ * @param size the size of each item in bytes
+ * @timeComplexity O(1) amortized
+ */
+static inline void popLast(LIST* lp, void* out, size_t size) {
+    LIST_STATS_START();
+    NODE* a = lp->head->prev;
+    if (out != NULL)
+        memcpy(out, slotAt(a, a->count - 1, size), size);
+    a->count--;
+    lp->count--;
+    if (a->count == 0 && a != lp->head)
+        listReleaseNode(lp, lp->numNodes - 1);
+    LIST_STATS_END(lp, pops);
+}
+
+/**
+ * Adds an item to the front of the list.
+ *
+ * @param lp the list to add the item to
+ * @param item the item to add (cant be null)
+ * @timeComplexity O(1)
+ */
+void addFirst(LIST* lp, void* item) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    assert(item != NULL);
+    *(void**) pushFirst(lp, sizeof(void*)) = item;
+}
+
+/**
+ * Adds an item to the end of the list.
+ *
+ * @param lp the list to add the item to
+ * @param item the item to add (cant be null)
+ * @timeComplexity O(1)
+ */
+void addLast(LIST* lp, void* item) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    assert(item != NULL);
+    *(void**) pushLast(lp, sizeof(void*)) = item;
+}
+
+
+/**
+ * Removes the item at the front of the list.  A node drained by the removal is unlinked and
+ * disposed of according to the trim policy of the list.
+ *
+ * @param lp the list to remove the first element from
+ * @return the removed element
+ * @timeComplexity O(1) amortized
+ */
+void* removeFirst(LIST* lp) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    assert(lp->count > 0);
+    void* item;
+    popFirst(lp, &item, sizeof(void*));
+    return item;
+}
+
+/**
+ * Removes the last element from the array.  A node drained by the removal is unlinked and
+ * disposed of according to the trim policy of the list.
+ *
+ * @param lp the list to remove the last element from
+ * @return the removed element
+ * @timeComplexity O(1) amortized
+ */
+void* removeLast(LIST* lp) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    assert(lp->count > 0);
+    void* item;
+    popLast(lp, &item, sizeof(void*));
+    return item;
+}
+
+/**
+ * Returns the first element in the list.
+ *
+ * @param lp the list to get the first element from
+ * @return the first element
+ * @timeComplexity O(1)
+ */
+void* getFirst(LIST* lp) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    return *(void**) getFirstRef(lp);
+}
+
+/**
+ * Returns the last element in the list.
+ *
+ * @param lp the list to get the last element from
+ * @return the last element
+ * @timeComplexity O(1)
+ */
+void* getLast(LIST* lp) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    return *(void**) getLastRef(lp);
+}
+
+/**
+ * Returns the item at the given index.
+ *
+ * @param lp the list to access
+ * @param index the index of access
+ * @return the item at the given index
+ * @timeComplexity O(log(M)) where M is the number of nodes
+ */
+void* getItem(LIST* lp, int index) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    return *(void**) getItemRef(lp, index);
+}
+
+/**
+ * Sets the item at the given index to the given item.
+ *
+ * @param lp the list to modify
+ * @param index the index to edit
+ * @param item the new value of the item
+ * @timeComplexity O(log(M)) where M is the number of nodes
+ */
+void setItem(LIST* lp, int index, void* item) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    *(void**) getItemRef(lp, index) = item;
+}
+
+/**
+ * Copies an item to the front of the list.
+ *
+ * @param lp the list to add the item to
+ * @param elem the address of the item
+ * @timeComplexity O(1)
+ */
+void addFirstValue(LIST* lp, const void* elem) {
+    assert(lp != NULL && elem != NULL);
+    memcpy(pushFirst(lp, lp->elemSize), elem, lp->elemSize);
+}
+
+/**
+ * Copies an item to the end of the list.
+ *
+ * @param lp the list to add the item to
+ * @param elem the address of the item
+ * @timeComplexity O(1)
+ */
+void addLastValue(LIST* lp, const void* elem) {
+    assert(lp != NULL && elem != NULL);
+    memcpy(pushLast(lp, lp->elemSize), elem, lp->elemSize);
+}
+
+/**
+ * Removes the item at the front of the list, copying it out.
+ *
+ * @param lp the list to remove the item from
+ * @param out where to copy the item (can be null to discard it)
+ * @timeComplexity O(1) amortized
+ */
+void removeFirstValue(LIST* lp, void* out) {
+    assert(lp != NULL);
+    assert(lp->count > 0);
+    popFirst(lp, out, lp->elemSize);
+}
+
+/**
+ * Removes the item at the end of the list, copying it out.
+ *
+ * @param lp the list to remove the item from
+ * @param out where to copy the item (can be null to discard it)
+ * @timeComplexity O(1) amortized
+ */
+void removeLastValue(LIST* lp, void* out) {
+    assert(lp != NULL);
+    assert(lp->count > 0);
+    popLast(lp, out, lp->elemSize);
+}
+
+/**
+ * Returns the address of the first item.  The address stays valid until the list is next
+ * modified other than through the address itself.
+ *
+ * @param lp the list to access
+ * @return the address of the first item
+ * @timeComplexity O(1)
+ */
+void* getFirstRef(LIST* lp) {
+    assert(lp != NULL);
+    assert(lp->count > 0);
+    NODE* a = lp->head;
+    return a->data + (size_t) a->firstIndex * lp->elemSize;
+}
+
+/**
+ * Returns the address of the last item.
+ *
+ * @param lp the list to access
+ * @return the address of the last item
+ * @timeComplexity O(1)
+ */
+void* getLastRef(LIST* lp) {
+    assert(lp != NULL);
+    assert(lp->count > 0);
+    NODE* a = lp->head->prev;
+    return slotAt(a, a->count - 1, lp->elemSize);
+}
+
+/**
+ * Returns the address of the item at the given index.
+ *
+ * @param lp the list to access
+ * @param index the index of access
+ * @return the address of the item
+ * @timeComplexity O(log(M)) where M is the number of nodes
+ */
+void* getItemRef(LIST* lp, int index) {
+    assert(lp != NULL);
+    assert(index >= 0 && index < lp->count);
+    unsigned offset;
+    NODE* np = lp->index[findEntry(lp, index, &offset)].np;
+    return slotAt(np, offset, lp->elemSize);
+}
+
+/**
+ * Inserts an item by value so that it has the given index, shifting the items within its node
+ * only.  A node in the middle of the list that grows past about twice the square root of the
+ * number of items is split in two.
+ *
+ * @param lp the list to add to
+ * @param index the index of the new item, from zero to the number of items
+ * @param elem the address of the item to copy in (cant be null)
+ * @timeComplexity O(sqrt(N)) amortized; O(1) amortized at either end
+ */
+void addAtValue(LIST* lp, int index, const void* elem) {
+    assert(lp != NULL && elem != NULL);
+    assert(index >= 0 && index <= lp->count);
+    if (index == 0)
+        memcpy(pushFirst(lp, lp->elemSize), elem, lp->elemSize);
+    else if (index == lp->count)
+        memcpy(pushLast(lp, lp->elemSize), elem, lp->elemSize);
+    else {
+        unsigned offset;
+        int pos = prepareInsert(lp, index, &offset);
+        insertInNode(lp, pos, offset, elem);
+    }
+}
+
+/**
+ * Inserts an item so that it has the given index.
+ *
+ * @param lp the list to add to
+ * @param index the index of the new item, from zero to the number of items
+ * @param item the item to add (cant be null)
+ * @timeComplexity O(sqrt(N)) amortized; O(1) amortized at either end
+ */
+void addAt(LIST* lp, int index, void* item) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    assert(item != NULL);
+    addAtValue(lp, index, &item);
+}
+
+/**
+ * Removes the item at the given index, copying it out, by shifting the items within its node
+ * only.  A node in the middle of the list that is over the middle node limit is first split
+ * in two, and one that falls to a quarter of the limit is merged into a neighbor with room.
+ *
+ * @param lp the list to remove from
+ * @param index the index of the item
+ * @param out where to copy the removed item (can be null)
+ * @timeComplexity O(sqrt(N)) amortized; O(1) amortized at either end
+ */
+void removeAtValue(LIST* lp, int index, void* out) {
+    assert(lp != NULL);
+    assert(index >= 0 && index < lp->count);
+    if (index == 0) {
+        popFirst(lp, out, lp->elemSize);
+        return;
+    }
+    if (index == lp->count - 1) {
+        popLast(lp, out, lp->elemSize);
+        return;
+    }
+
+    unsigned offset, limit = middleNodeLimit(lp);
+    if (limit > lp->maxCapacity)
+        limit = lp->maxCapacity;
+    int pos = findEntry(lp, index, &offset);
+    while (lp->index[pos].np->count > limit) {
+        splitNode(lp, pos, lp->index[pos].np->count / 2);
+        pos = findEntry(lp, index, &offset);
+    }
+    int numNodes = lp->numNodes;
+    removeInNode(lp, pos, offset, out);
+    if (lp->numNodes == numNodes && lp->index[pos].np->count <= limit / 4)
+        if (pos == 0 || !mergeNodes(lp, pos - 1))
+            if (pos + 1 < lp->numNodes)
+                mergeNodes(lp, pos);
+}
+
+/**
+ * Removes the item at the given index.
+ *
+ * @param lp the list to remove from
+ * @param index the index of the item
+ * @return the removed item
+ * @timeComplexity O(sqrt(N)) amortized; O(1) amortized at either end
+ */
+void* removeAt(LIST* lp, int index) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    void* item;
+    removeAtValue(lp, index, &item);
+    return item;
+}
+
+/**
+ * Adds n items to the end of the list, in order.  Items are copied into the last node in
+ * contiguous runs, and any that do not fit go into new nodes, each as large as the growth
+ * policy allows.
+ *
+ * @param lp the list to add the items to
+ * @param items the items to add (cant be null)
+ * @param n the number of items
+ * @timeComplexity O(n)
+ */
+void addLastN(LIST* lp, const void* items, int n) {
+    assert(lp != NULL);
+    assert(items != NULL && n >= 0);
+    const char* src = items;
+    while (true) {
+        NODE* lastNode = lp->head->prev;
+        unsigned k = lastNode->capacity - lastNode->count;
+        if (k > (unsigned) n)
+            k = n;
+        ringWrite(lp, lastNode, lastNode->count, src, k);
+        lastNode->count += k;
+        lp->count += k;
+        src += (size_t) k * lp->elemSize;
+        n -= k;
+        if (n == 0)
+            return;
+        NODE* newNode = obtainNode(lp, growCapacity(lp, lastNode->capacity, n), 1, lp->head, lastNode);
+        lastNode->next = newNode;
+        lp->head->prev = newNode;
+        ENTRY* last = &lp->index[lp->numNodes - 1];
+        indexInsert(lp, lp->numNodes, newNode, last->start + last->np->count);
+    }
+}
+
+/**
+ * Adds n items to the front of the list, keeping their order, so that items[0] becomes the
+ * first item.  Items are copied into the first node in contiguous runs, and any that do not
+ * fit go into new nodes, each as large as the growth policy allows.
+ *
+ * @param lp the list to add the items to
+ * @param items the items to add (cant be null)
+ * @param n the number of items
+ * @timeComplexity O(n)
+ */
+void addFirstN(LIST* lp, const void* items, int n) {
+    assert(lp != NULL);
+    assert(items != NULL && n >= 0);
+    while (true) {
+        NODE* front = lp->head;
+        unsigned k = front->capacity - front->count;
+        if (k > (unsigned) n)
+            k = n;
+        n -= k;
+        front->firstIndex = (front->firstIndex - k) & front->mask;
+        ringWrite(lp, front, 0, (const char*) items + (size_t) n * lp->elemSize, k);
+        front->count += k;
+        lp->index[0].start -= k;
+        lp->count += k;
+        if (n == 0)
+            return;
+        NODE* np = obtainNode(lp, growCapacity(lp, front->capacity, n), 1, front, front->prev);
+        front->prev->next = np;
+        front->prev = np;
+        lp->head = np;
+        indexInsert(lp, 0, np, lp->index[0].start);
+    }
+}
+
+/**
+ * Removes the first n items of the list, copying them to out in order.  Nodes are drained in
+ * contiguous runs.
+ *
+ * @param lp the list to remove the items from
+ * @param out where to store the removed items
+ * @param n the number of items, at most numItems(lp)
+ * @timeComplexity O(n)
+ */
+void removeFirstN(LIST* lp, void* out, int n) {
+    assert(lp != NULL);
+    assert(out != NULL && n >= 0 && n <= lp->count);
+    while (n > 0) {
+        NODE* front = lp->head;
+        unsigned k = front->count < (unsigned) n ? front->count : (unsigned) n;
+        ringRead(lp, front, 0, out, k);
+        front->firstIndex = (front->firstIndex + k) & front->mask;
+        front->count -= k;
+        lp->index[0].start += k;
+        lp->count -= k;
+        out = (char*) out + (size_t) k * lp->elemSize;
+        n -= k;
+        if (front->count == 0 && front->next != front)
+            listReleaseNode(lp, 0);
+    }
+}
+
+/**
+ * Removes the last n items of the list, copying them to out in list order, so that the last
+ * item ends up in out[n - 1].  Nodes are drained in contiguous runs.
+ *
+ * @param lp the list to remove the items from
+ * @param out where to store the removed items
+ * @param n the number of items, at most numItems(lp)
+ * @timeComplexity O(n)
+ */
+void removeLastN(LIST* lp, void* out, int n) {
+    assert(lp != NULL);
+    assert(out != NULL && n >= 0 && n <= lp->count);
+    while (n > 0) {
+        NODE* a = lp->head->prev;
+        unsigned k = a->count < (unsigned) n ? a->count : (unsigned) n;
+        n -= k;
+        a->count -= k;
+        ringRead(lp, a, a->count, (char*) out + (size_t) n * lp->elemSize, k);
+        lp->count -= k;
+        if (a->count == 0 && a != lp->head)
+            listReleaseNode(lp, lp->numNodes - 1);
+    }
+}
+
+/**
+ * Moves all of the items of src to the end of dst, leaving src empty.  When both lists use
+ * the same allocator the nodes of src are relinked into dst rather than copied.
+ *
+ * @param dst the list to append to
+ * @param src the list whose items to move
+ * @timeComplexity O(M) where M is the number of nodes of both lists; O(N) items when the
+ * allocators differ
+ */
+void listConcat(LIST* dst, LIST* src) {
+    assert(dst != NULL && src != NULL && dst != src);
+    assert(dst->elemSize == src->elemSize);
+    if (src->count == 0)
+        return;
+    if (dst->alloc != src->alloc || dst->release != src->release || dst->ctx != src->ctx) {
+        char buf[4096];
+        int batch = sizeof(buf) / src->elemSize;
+        while (src->count > 0) {
+            int k = src->count < batch ? src->count : batch;
+            if (k == 0) {
+                memcpy(pushLast(dst, dst->elemSize), getFirstRef(src), src->elemSize);
+                popFirst(src, NULL, src->elemSize);
+                continue;
+            }
+            removeFirstN(src, buf, k);
+            addLastN(dst, buf, k);
+        }
+        return;
+    }
+    NODE* first = src->head;
+    NODE* last = src->head->prev;
+    long slots = 0;
+    for (int i = 0; i < src->numNodes; i++)
+        slots += src->index[i].np->capacity;
+    if (dst->count == 0) {
+        NODE* np = dst->head;
+        dst->head = first;
+        freeNode(dst, np);
+    } else {
+        NODE* tail = dst->head->prev;
+        tail->next = first;
+        first->prev = tail;
+        last->next = dst->head;
+        dst->head->prev = last;
+    }
+    dst->count += src->count;
+    dst->slots += slots;
+    rebuildIndex(dst);
+    src->slots -= slots;
+    src->count = 0;
+    src->head = obtainNode(src, src->initialCapacity, 1, NULL, NULL);
+    src->head->next = src->head;
+    src->head->prev = src->head;
+    rebuildIndex(src);
+}
+
+/**
+ * Splits a list in two at the given index.  The items from index onward are moved to a new
+ * list that shares the allocator, trim policy and growth policy of the original.  At most one
+ * node is split; the rest are relinked.
+ *
+ * @param lp the list to split
+ * @param index the index of the first item of the new list
+ * @return the new list
+ * @timeComplexity O(C + M) where C is the capacity of the node split and M is the number of
+ * nodes
+ */
+LIST* listSplitAt(LIST* lp, int index) {
+    assert(lp != NULL);
+    assert(index >= 0 && index <= lp->count);
+    LIST* nl = createListOfSizeWithAllocator(lp->elemSize, lp->alloc, lp->release, lp->ctx);
+    nl->trimPolicy = lp->trimPolicy;
+    nl->trimParam = lp->trimParam;
+    nl->growthFactor = lp->growthFactor;
+    nl->maxCapacity = lp->maxCapacity;
+    nl->initialCapacity = lp->initialCapacity;
+    if (index == lp->count)
+        return nl;
+    if (index == 0) {
+        LIST tmp = *nl;
+        long slots = 0;
+        for (int i = 0; i < lp->numNodes; i++)
+            slots += lp->index[i].np->capacity;
+        nl->head = lp->head;
+        nl->count = lp->count;
+        nl->slots = slots;
+        lp->head = tmp.head;
+        lp->count = tmp.count;
+        lp->slots += tmp.slots - slots;
+        rebuildIndex(lp);
+        rebuildIndex(nl);
+        return nl;
+    }
+    unsigned offset;
+    int pos = findEntry(lp, index, &offset);
+    if (offset > 0)
+        splitNode(lp, pos++, offset);
+    NODE* first = lp->index[pos].np;
+    NODE* last = lp->head->prev;
+    NODE* keep = lp->index[pos - 1].np;
+    long slots = 0;
+    for (int i = pos; i < lp->numNodes; i++)
+        slots += lp->index[i].np->capacity;
+    keep->next = lp->head;
+    lp->head->prev = keep;
+    first->prev = last;
+    last->next = first;
+    freeNode(nl, nl->head);
+    nl->head = first;
+    nl->count = lp->count - index;
+    nl->slots += slots;
+    lp->slots -= slots;
+    lp->count = index;
+    lp->numNodes = pos;
+    rebuildIndex(nl);
+    return nl;
+}
+
+/**
+ * Rotates a list so that the item at index k becomes the first item.  A positive k moves the
+ * first k items to the end and a negative k moves the last -k items to the front.  At most
+ * one node is split; the rest only change places in the circular node chain.
+ *
+ * @param lp the list to rotate
+ * @param k the number of items to rotate by
+ * @timeComplexity O(C + M) where C is the capacity of the node split and M is the number of
+ * nodes
+ */
+void listRotate(LIST* lp, int k) {
+    assert(lp != NULL);
+    if (lp->count == 0)
+        return;
+    k %= lp->count;
+    if (k < 0)
+        k += lp->count;
+    if (k == 0)
+        return;
+    unsigned offset;
+    int pos = findEntry(lp, k, &offset);
+    if (offset > 0)
+        splitNode(lp, pos++, offset);
+    lp->head = lp->index[pos].np;
+    rebuildIndex(lp);
+}
+
+/**
+ * Positions a cursor at the given index of a list.  An index of -1 or numItems(lp) places the
+ * cursor just before the first item or just after the last one.  A cursor stays valid until
+ * the list is modified other than through listCursorSet or listCursorRemove.
+ *
+ * @param cp the cursor to position
+ * @param lp the list to traverse
+ * @param index the index of the item, or -1 or numItems(lp)
+ * @timeComplexity O(log(M)) where M is the number of nodes
+ */
+void listCursorSeek(LIST_CURSOR* cp, LIST* lp, int index) {
+    assert(cp != NULL && lp != NULL);
+    assert(index >= -1 && index <= lp->count);
+    cp->lp = lp;
+    cp->index = index;
+    if (index < 0 || index == lp->count) {
+        cp->np = NULL;
+        cp->pos = index < 0 ? -1 : lp->numNodes;
+        cp->offset = 0;
+    } else {
+        cp->pos = findEntry(lp, index, &cp->offset);
+        cp->np = lp->index[cp->pos].np;
+    }
+}
+
+/**
+ * Moves a cursor to the next item.
+ *
+ * @param cp the cursor to move
+ * @return true if the cursor is on an item, false if it moved past the last one
+ * @timeComplexity O(1)
+ */
+bool listCursorNext(LIST_CURSOR* cp) {
+    assert(cp != NULL && cp->index < cp->lp->count);
+    if (cp->np == NULL) {
+        listCursorSeek(cp, cp->lp, cp->index + 1);
+        return cp->np != NULL;
+    }
+    if (++cp->index == cp->lp->count) {
+        cp->np = NULL;
+        cp->pos = cp->lp->numNodes;
+        cp->offset = 0;
+        return false;
+    }
+    if (++cp->offset == cp->np->count) {
+        cp->np = cp->np->next;
+        cp->pos++;
+        cp->offset = 0;
+    }
+    return true;
+}
+
+/**
+ * Moves a cursor to the previous item.
+ *
+ * @param cp the cursor to move
+ * @return true if the cursor is on an item, false if it moved before the first one
+ * @timeComplexity O(1)
+ */
+bool listCursorPrev(LIST_CURSOR* cp) {
+    assert(cp != NULL && cp->index >= 0);
+    if (cp->np == NULL) {
+        listCursorSeek(cp, cp->lp, cp->index - 1);
+        return cp->np != NULL;
+    }
+    if (--cp->index < 0) {
+        cp->np = NULL;
+        cp->pos = -1;
+        cp->offset = 0;
+        return false;
+    }
+    if (cp->offset-- == 0) {
+        cp->np = cp->np->prev;
+        cp->pos--;
+        cp->offset = cp->np->count - 1;
+    }
+    return true;
+}
+
+/**
+ * Returns the item under a cursor.
+ *
+ * @param cp the cursor
+ * @return the item under the cursor
+ * @timeComplexity O(1)
+ */
+void* listCursorGet(LIST_CURSOR* cp) {
+    assert(cp != NULL && cp->np != NULL);
+    return *(void**) slotAt(cp->np, cp->offset, sizeof(void*));
+}
+
+/**
+ * Replaces the item under a cursor.
+ *
+ * @param cp the cursor
+ * @param item the new value of the item
+ * @timeComplexity O(1)
+ */
+void listCursorSet(LIST_CURSOR* cp, void* item) {
+    assert(cp != NULL && cp->np != NULL);
+    assert(item != NULL);
+    *(void**) slotAt(cp->np, cp->offset, sizeof(void*)) = item;
+}
+
+/**
+ * Returns the address of the item under a cursor.
+ *
+ * @param cp the cursor
+ * @return the address of the item under the cursor
+ * @timeComplexity O(1)
+ */
+void* listCursorRef(LIST_CURSOR* cp) {
+    assert(cp != NULL && cp->np != NULL);
+    return slotAt(cp->np, cp->offset, cp->lp->elemSize);
+}
+
+/**
+ * Removes the item under a cursor, copying it out and leaving the cursor on the item that
+ * followed it.
+ *
+ * @param cp the cursor
+ * @param out where to copy the removed item (can be null)
+ * @timeComplexity O(C + M) where C is the node capacity and M is the number of nodes
+ */
+void listCursorRemoveValue(LIST_CURSOR* cp, void* out) {
+    assert(cp != NULL && cp->np != NULL);
+    LIST* lp = cp->lp;
+    int numNodes = lp->numNodes;
+    removeInNode(lp, cp->pos, cp->offset, out);
+    if (cp->index == lp->count) {
+        cp->np = NULL;
+        cp->pos = lp->numNodes;
+        cp->offset = 0;
+    } else if (lp->numNodes < numNodes || cp->offset == cp->np->count) {
+        if (lp->numNodes == numNodes)
+            cp->pos++;
+        cp->np = lp->index[cp->pos].np;
+        cp->offset = 0;
+    }
+}
+
+/**
+ * Removes the item under a cursor, leaving the cursor on the item that followed it.
+ *
+ * @param cp the cursor
+ * @return the removed item
+ * @timeComplexity O(C + M) where C is the node capacity and M is the number of nodes
+ */
+void* listCursorRemove(LIST_CURSOR* cp) {
+    assert(cp != NULL && cp->lp->elemSize == sizeof(void*));
+    void* item;
+    listCursorRemoveValue(cp, &item);
+    return item;
+}
+
+/**
+ * Returns the index of the item under a cursor.
+ *
+ * @param cp the cursor
+ * @return the index, which is -1 or numItems(lp) when the cursor is off either end
+ * @timeComplexity O(1)
+ */
+int listCursorIndex(LIST_CURSOR* cp) {
+    assert(cp != NULL);
+    return cp->index;
+}
+
+/**
+ * Returns the length of the first of the at most two contiguous spans of slots holding a node's
+ * items, the one starting at the node's first item; the second span, if any, starts at slot
+ * zero and holds the rest.
+ *
+ * @param np the node
+ * @param first where to store the slot of the node's first item
+ * @return the number of items in the first span
+ * @timeComplexity O(1)
+ */
+static inline unsigned firstSpan(NODE* np, unsigned* first) {
+    *first = np->firstIndex & np->mask;
+    return np->capacity - *first < np->count ? np->capacity - *first : np->count;
+}
+
+/**
+ * Returns the position of the first of n pointers equal to the given one, comparing one at a
+ * time.
+ *
+ * @param items the pointers
+ * @param n the number of pointers
+ * @param item the pointer to find
+ * @return the position, or n if there is none
+ * @timeComplexity O(n)
+ */
+static unsigned findFirstScalar(void* const* items, unsigned n, const void* item) {
+    unsigned i = 0;
+    while (i < n && items[i] != item)
+        i++;
+    return i;
+}
+
+/**
+ * Returns the position of the last of n pointers equal to the given one, comparing one at a
+ * time.
+ *
+ * @param items the pointers
+ * @param n the number of pointers
+ * @param item the pointer to find
+ * @return the position, or n if there is none
+ * @timeComplexity O(n)
+ */
+static unsigned findLastScalar(void* const* items, unsigned n, const void* item) {
+    for (unsigned i = n; i > 0; i--)
+        if (items[i - 1] == item)
+            return i - 1;
+    return n;
+}
+
+/**
+ * Counts the pointers among n that are equal to the given one, comparing one at a time.
+ *
+ * @param items the pointers
+ * @param n the number of pointers
+ * @param item the pointer to count
+ * @return the number of matches
+ * @timeComplexity O(n)
+ */
+static unsigned countScalar(void* const* items, unsigned n, const void* item) {
+    unsigned count = 0;
+    for (unsigned i = 0; i < n; i++)
+        count += items[i] == item;
+    return count;
+}
+
+#ifdef __x86_64__
+/*
+ * SSE2 is part of x86-64, so it is always available there; AVX2 is used when the processor
+ * reports it.  SSE2 has no 64-bit equality test, so two pointers are equal when both 32-bit
+ * halves are, which is found by ANDing each half's result with its neighbor's.
+ */
+/**
+ * Returns a two-bit mask of which of the two pointers at items equal the key.
+ */
+static inline int matchSSE2(void* const* items, __m128i key) {
+    __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) items), key);
+    eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_movemask_pd(_mm_castsi128_pd(eq));
+}
+
+/**
+ * Finds the first matching pointer as findFirstScalar does, four at a time with SSE2.
+ */
+static unsigned findFirstSSE2(void* const* items, unsigned n, const void* item) {
+    __m128i key = _mm_set1_epi64x((long long) (uintptr_t) item);
+    unsigned i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int mask = matchSSE2(items + i, key) | matchSSE2(items + i + 2, key) << 2;
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    return i + findFirstScalar(items + i, n - i, item);
+}
+
+/**
+ * Finds the last matching pointer as findLastScalar does, four at a time with SSE2.
+ */
+static unsigned findLastSSE2(void* const* items, unsigned n, const void* item) {
+    __m128i key = _mm_set1_epi64x((long long) (uintptr_t) item);
+    unsigned i = n;
+    for (; i >= 4; i -= 4) {
+        int mask = matchSSE2(items + i - 4, key) | matchSSE2(items + i - 2, key) << 2;
+        if (mask != 0)
+            return i - 4 + 31 - __builtin_clz(mask);
+    }
+    unsigned k = findLastScalar(items, i, item);
+    return k < i ? k : n;
+}
+
+/**
+ * Counts the matching pointers as countScalar does, two at a time with SSE2.
+ */
+static unsigned countSSE2(void* const* items, unsigned n, const void* item) {
+    __m128i key = _mm_set1_epi64x((long long) (uintptr_t) item);
+    __m128i sum = _mm_setzero_si128();
+    unsigned i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) (items + i)), key);
+        sum = _mm_sub_epi64(sum, _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i*) lanes, sum);
+    return lanes[0] + lanes[1] + countScalar(items + i, n - i, item);
+}
+
+/**
+ * Returns a four-bit mask of which of the four pointers at items equal the key.
+ */
+__attribute__((target("avx2"))) static inline int matchAVX2(void* const* items, __m256i key) {
+    __m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*) items), key);
+    return _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+}
+
+/**
+ * Finds the first matching pointer as findFirstScalar does, eight at a time with AVX2.
+ */
+__attribute__((target("avx2"))) static unsigned findFirstAVX2(void* const* items, unsigned n, const void* item) {
+    __m256i key = _mm256_set1_epi64x((long long) (uintptr_t) item);
+    unsigned i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int mask = matchAVX2(items + i, key) | matchAVX2(items + i + 4, key) << 4;
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    return i + findFirstScalar(items + i, n - i, item);
+}
+
+/**
+ * Finds the last matching pointer as findLastScalar does, eight at a time with AVX2.
+ */
+__attribute__((target("avx2"))) static unsigned findLastAVX2(void* const* items, unsigned n, const void* item) {
+    __m256i key = _mm256_set1_epi64x((long long) (uintptr_t) item);
+    unsigned i = n;
+    for (; i >= 8; i -= 8) {
+        int mask = matchAVX2(items + i - 8, key) | matchAVX2(items + i - 4, key) << 4;
+        if (mask != 0)
+            return i - 8 + 31 - __builtin_clz(mask);
+    }
+    unsigned k = findLastScalar(items, i, item);
+    return k < i ? k : n;
+}
+
+/**
+ * Counts the matching pointers as countScalar does, four at a time with AVX2.
+ */
+__attribute__((target("avx2"))) static unsigned countAVX2(void* const* items, unsigned n, const void* item) {
+    __m256i key = _mm256_set1_epi64x((long long) (uintptr_t) item);
+    __m256i sum = _mm256_setzero_si256();
+    unsigned i = 0;
+    for (; i + 4 <= n; i += 4)
+        sum = _mm256_sub_epi64(sum, _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*) (items + i)), key));
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*) lanes, sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + countScalar(items + i, n - i, item);
+}
+#endif
+
+/*
+ * The span functions used by the searches, chosen on first use.  Every set has the same
+ * results, so threads racing to choose store the same pointers.
+ */
+typedef struct matcher {
+    unsigned (*findFirst)(void* const* items, unsigned n, const void* item);
+    unsigned (*findLast)(void* const* items, unsigned n, const void* item);
+    unsigned (*count)(void* const* items, unsigned n, const void* item);
+} MATCHER;
+
+#ifdef __x86_64__
+static const MATCHER sse2Matcher = {findFirstSSE2, findLastSSE2, countSSE2};
+static const MATCHER avx2Matcher = {findFirstAVX2, findLastAVX2, countAVX2};
+#else
+static const MATCHER scalarMatcher = {findFirstScalar, findLastScalar, countScalar};
+#endif
+
+/**
+ * Returns the fastest span functions that the processor supports.
+ *
+ * @return the span functions
+ * @timeComplexity O(1)
+ */
+static const MATCHER* selectMatcher(void) {
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? &avx2Matcher : &sse2Matcher;
+#else
+    return &scalarMatcher;
+#endif
+}
+
+static const MATCHER* _Atomic matcher;
+
+/**
+ * Returns the span functions for this processor, choosing them on first use.
+ *
+ * @return the span functions
+ * @timeComplexity O(1)
+ */
+static inline const MATCHER* getMatcher(void) {
+    const MATCHER* mp = atomic_load_explicit(&matcher, memory_order_relaxed);
+    if (mp == NULL) {
+        mp = selectMatcher();
+        atomic_store_explicit(&matcher, mp, memory_order_relaxed);
+    }
+    return mp;
+}
+
+/**
+ * Returns the index of the first item of a list of pointers that is equal to the given pointer.
+ * Each node's items are compared in at most two contiguous spans, several at a time with SIMD
+ * instructions where the processor has them.
+ *
+ * @param lp the list to search, created with createList
+ * @param item the pointer to find
+ * @return the index of the first match, or -1 if there is none
+ * @timeComplexity O(N)
+ */
+int listIndexOf(LIST* lp, void* item) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    const MATCHER* mp = getMatcher();
+    int base = 0;
+    NODE* np = lp->head;
+    do {
+        void** items = (void**) np->data;
+        unsigned first, run = firstSpan(np, &first);
+        unsigned k = mp->findFirst(items + first, run, item);
+        if (k < run)
+            return base + k;
+        k = mp->findFirst(items, np->count - run, item);
+        if (k < np->count - run)
+            return base + run + k;
+        base += np->count;
+        np = np->next;
+    } while (np != lp->head);
+    return -1;
+}
+
+/**
+ * Returns the index of the last item of a list of pointers that is equal to the given pointer,
+ * searching from the end as listIndexOf searches from the front.
+ *
+ * @param lp the list to search, created with createList
+ * @param item the pointer to find
+ * @return the index of the last match, or -1 if there is none
+ * @timeComplexity O(N)
+ */
+int listLastIndexOf(LIST* lp, void* item) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    const MATCHER* mp = getMatcher();
+    int base = lp->count;
+    NODE* np = lp->head;
+    do {
+        np = np->prev;
+        base -= np->count;
+        void** items = (void**) np->data;
+        unsigned first, run = firstSpan(np, &first);
+        unsigned k = mp->findLast(items, np->count - run, item);
+        if (k < np->count - run)
+            return base + run + k;
+        k = mp->findLast(items + first, run, item);
+        if (k < run)
+            return base + k;
+    } while (np != lp->head);
+    return -1;
+}
+
+/**
+ * Returns the number of items of a list of pointers that are equal to the given pointer,
+ * comparing them as listIndexOf does.
+ *
+ * @param lp the list to search, created with createList
+ * @param item the pointer to count
+ * @return the number of matches
+ * @timeComplexity O(N)
+ */
+int listCount(LIST* lp, void* item) {
+    assert(lp != NULL && lp->elemSize == sizeof(void*));
+    const MATCHER* mp = getMatcher();
+    int count = 0;
+    NODE* np = lp->head;
+    do {
+        void** items = (void**) np->data;
+        unsigned first, run = firstSpan(np, &first);
+        count += mp->count(items + first, run, item) + mp->count(items, np->count - run, item);
+        np = np->next;
+    } while (np != lp->head);
+    return count;
+}
+
+/**
+ * Returns the index of the first item of a list for which the predicate is true.  The
+ * predicate is passed the address of each item in turn, as the sort's comparison is, so it
+ * works on lists of any item size.
+ *
+ * @param lp the list to search
+ * @param pred the predicate
+ * @return the index of the first item satisfying the predicate, or -1 if there is none
+ * @timeComplexity O(N)
+ */
+int listFindIf(LIST* lp, bool (*pred)(const void*)) {
+    assert(lp != NULL && pred != NULL);
+    size_t size = lp->elemSize;
+    int base = 0;
+    NODE* np = lp->head;
+    do {
+        unsigned first, run = firstSpan(np, &first);
+        const char* p = np->data + (size_t) first * size;
+        for (unsigned i = 0; i < np->count; i++, p += size) {
+            if (i == run)
+                p = np->data;
+            if (pred(p))
+                return base + i;
+        }
+        base += np->count;
+        np = np->next;
+    } while (np != lp->head);
+    return -1;
+}
+
+/**
+ * Moves a cursor that is known to be on an item to the next item, which must exist.
+ *
+ * @param cp the cursor to move
+ * @timeComplexity O(1)
+ */
+static inline void stepNext(LIST_CURSOR* cp) {
+    cp->index++;
+    if (++cp->offset == cp->np->count) {
+        cp->np = cp->np->next;
+        cp->pos++;
+        cp->offset = 0;
+    }
+}
+
+/**
+ * Moves a cursor that is known to be on an item to the previous item, which must exist.
+ *
+ * @param cp the cursor to move
+ * @timeComplexity O(1)
+ */
+static inline void stepPrev(LIST_CURSOR* cp) {
+    cp->index--;
+    if (cp->offset-- == 0) {
+        cp->np = cp->np->prev;
+        cp->pos--;
+        cp->offset = cp->np->count - 1;
+    }
+}
+
+/**
+ * Swaps two items of the given size.
+ *
+ * @param a the address of the first item
+ * @param b the address of the second item
+ * @param tmp scratch space of at least size bytes
+ * @param size the size of each item in bytes
+ * @timeComplexity O(size)
+ */
+static inline void swapItems(char* a, char* b, char* tmp, size_t size) {
+    if (size == sizeof(void*)) {
+        void* t = *(void**) a;
+        *(void**) a = *(void**) b;
+        *(void**) b = t;
+    } else {
+        memcpy(tmp, a, size);
+        memcpy(a, b, size);
+        memcpy(b, tmp, size);
+    }
+}
+
+#define INSERTION_SORT_THRESHOLD 16
+
+/**
+ * Sorts the items from lo to hi inclusive by insertion, walking with cursors.
+ *
+ * @param lp the list to sort
+ * @param lo the index of the first item
+ * @param hi the index of the last item
+ * @param cmp the comparison function, passed the addresses of two items
+ * @param tmp scratch space for one item
+ * @timeComplexity O(K^2) where K is hi - lo + 1
+ */
+static void insertionSortRange(LIST* lp, int lo, int hi, int (*cmp)(const void*, const void*), char* tmp) {
+    size_t size = lp->elemSize;
+    LIST_CURSOR k, hole, j;
+    listCursorSeek(&k, lp, lo);
+    for (int i = lo + 1; i <= hi; i++) {
+        stepNext(&k);
+        memcpy(tmp, slotAt(k.np, k.offset, size), size);
+        hole = k;
+        j = k;
+        stepPrev(&j);
+        while (cmp(slotAt(j.np, j.offset, size), tmp) > 0) {
+            memcpy(slotAt(hole.np, hole.offset, size), slotAt(j.np, j.offset, size), size);
+            hole = j;
+            if (j.index == lo)
+                break;
+            stepPrev(&j);
+        }
+        memcpy(slotAt(hole.np, hole.offset, size), tmp, size);
+    }
+}
+
+/**
+ * Restores the heap property below the given root of a max-heap laid out over the items from
+ * lo onward.
+ *
+ * @param lp the list to sort
+ * @param lo the index of the first item of the heap
+ * @param root the heap position of the root
+ * @param n the number of items in the heap
+ * @param cmp the comparison function
+ * @param tmp scratch space for one item
+ * @timeComplexity O(log(K) log(M)) where K is the heap size and M is the number of nodes
+ */
+static void siftDown(LIST* lp, int lo, int root, int n, int (*cmp)(const void*, const void*), char* tmp) {
+    char* rp = getItemRef(lp, lo + root);
+    while (2 * root + 1 < n) {
+        int child = 2 * root + 1;
+        char* cp = getItemRef(lp, lo + child);
+        if (child + 1 < n) {
+            char* sp = getItemRef(lp, lo + child + 1);
+            if (cmp(cp, sp) < 0) {
+                child++;
+                cp = sp;
+            }
+        }
+        if (cmp(rp, cp) >= 0)
+            return;
+        swapItems(rp, cp, tmp, lp->elemSize);
+        root = child;
+        rp = cp;
+    }
+}
+
+/**
+ * Sorts the items from lo to hi inclusive by heapsort.  This is the fallback that bounds the
+ * worst case of the introsort.
+ *
+ * @param lp the list to sort
+ * @param lo the index of the first item
+ * @param hi the index of the last item
+ * @param cmp the comparison function
+ * @param tmp scratch space for one item
+ * @timeComplexity O(K log(K) log(M)) where K is hi - lo + 1 and M is the number of nodes
+ */
+static void heapSortRange(LIST* lp, int lo, int hi, int (*cmp)(const void*, const void*), char* tmp) {
+    int n = hi - lo + 1;
+    for (int i = n / 2 - 1; i >= 0; i--)
+        siftDown(lp, lo, i, n, cmp, tmp);
+    for (int i = n - 1; i > 0; i--) {
+        swapItems(getItemRef(lp, lo), getItemRef(lp, lo + i), tmp, lp->elemSize);
+        siftDown(lp, lo, 0, i, cmp, tmp);
+    }
+}
+
+/**
+ * Sorts the items from lo to hi inclusive by introsort: Hoare partitioning around a median
+ * of three, recursing on the smaller side and looping on the larger, with insertion sort for
+ * small ranges and heapsort once the depth limit is used up.
+ *
+ * @param lp the list to sort
+ * @param lo the index of the first item
+ * @param hi the index of the last item
+ * @param depth the number of partitioning levels left before falling back to heapsort
+ * @param cmp the comparison function
+ * @param pivot scratch space for one item
+ * @param tmp scratch space for one item
+ * @timeComplexity O(K log(K)) where K is hi - lo + 1
+ */
+static void introSortRange(LIST* lp, int lo, int hi, int depth, int (*cmp)(const void*, const void*),
+                           char* pivot, char* tmp) {
+    size_t size = lp->elemSize;
+    while (hi - lo + 1 > INSERTION_SORT_THRESHOLD) {
+        if (depth-- == 0) {
+            heapSortRange(lp, lo, hi, cmp, tmp);
+            return;
+        }
+        char* a = getItemRef(lp, lo);
+        char* b = getItemRef(lp, lo + (hi - lo) / 2);
+        char* c = getItemRef(lp, hi);
+        if (cmp(b, a) < 0)
+            swapItems(a, b, tmp, size);
+        if (cmp(c, b) < 0) {
+            swapItems(b, c, tmp, size);
+            if (cmp(b, a) < 0)
+                swapItems(a, b, tmp, size);
+        }
+        memcpy(pivot, b, size);
+
+        LIST_CURSOR i, j;
+        listCursorSeek(&i, lp, lo);
+        listCursorSeek(&j, lp, hi);
+        while (1) {
+            while (cmp(slotAt(i.np, i.offset, size), pivot) < 0)
+                stepNext(&i);
+            while (cmp(slotAt(j.np, j.offset, size), pivot) > 0)
+                stepPrev(&j);
+            if (i.index >= j.index)
+                break;
+            swapItems(slotAt(i.np, i.offset, size), slotAt(j.np, j.offset, size), tmp, size);
+            stepNext(&i);
+            stepPrev(&j);
+        }
+
+        int p = j.index;
+        if (p - lo < hi - p) {
+            introSortRange(lp, lo, p, depth, cmp, pivot, tmp);
+            lo = p + 1;
+        } else {
+            introSortRange(lp, p + 1, hi, depth, cmp, pivot, tmp);
+            hi = p;
+        }
+    }
+    if (hi > lo)
+        insertionSortRange(lp, lo, hi, cmp, tmp);
+}
+
+/**
+ * Sorts the list in place.  The comparison function is passed the addresses of two items, as
+ * with qsort, so for a list of pointers it receives pointers to the pointers.  The sort is an
+ * introsort that walks the node ring buffers directly with cursors; it is not stable.
+ *
+ * @param lp the list to sort
+ * @param cmp the comparison function
+ * @timeComplexity O(N log(N))
+ */
+void listSort(LIST* lp, int (*cmp)(const void*, const void*)) {
+    assert(lp != NULL && cmp != NULL);
+    if (lp->count < 2)
+        return;
+    int depth = 0;
+    for (int n = lp->count; n > 1; n /= 2)
+        depth += 2;
+    char* scratch = malloc(2 * lp->elemSize);
+    assert(scratch != NULL);
+    introSortRange(lp, 0, lp->count - 1, depth, cmp, scratch, scratch + lp->elemSize);
+    free(scratch);
+}
+
+/**
+ * Moves items from one buffer to another in the order given by one byte of their keys, using
+ * the running bucket positions in next.  The pass is stable, as LSD radix sort requires.
+ *
+ * @param src the items to move
+ * @param dst the destination, with room for n items
+ * @param n the number of items
+ * @param size the size of each item in bytes
+ * @param key the key function
+ * @param shift the bit position of the byte
+ * @param next the position in dst of the next item of each byte value
+ * @timeComplexity O(n)
+ */
+static inline void radixPass(const char* src, char* dst, int n, size_t size, uint64_t (*key)(const void*),
+                             int shift, size_t* next) {
+    for (int i = 0; i < n; i++, src += size)
+        memcpy(dst + next[(key(src) >> shift) & 0xff]++ * size, src, size);
+}
+
+/**
+ * Sorts the list in place by the unsigned keys that the key function returns for the addresses
+ * of its items.  The sort is a least significant digit radix sort over bytes: one pass counts
+ * the occurrences of every byte of every key, and then each byte that differs between keys gets
+ * a stable counting sort between the list's items copied into a buffer and a scratch buffer.
+ * Bytes that all keys share are skipped, so 32-bit keys take at most four passes.
+ *
+ * @param lp the list to sort
+ * @param key the key function, passed the address of an item
+ * @timeComplexity O(N)
+ */
+void listRadixSort(LIST* lp, uint64_t (*key)(const void*)) {
+    assert(lp != NULL && key != NULL);
+    if (lp->count < 2)
+        return;
+    int n = lp->count;
+    size_t size = lp->elemSize;
+    size_t (*counts)[256] = calloc(8, sizeof(*counts));
+    char* items = scratchAlloc(lp, (size_t) n * size);
+    char* scratch = scratchAlloc(lp, (size_t) n * size);
+    assert(counts != NULL);
+
+    char* dst = items;
+    NODE* np = lp->head;
+    do {
+        ringRead(lp, np, 0, dst, np->count);
+        dst += (size_t) np->count * size;
+        np = np->next;
+    } while (np != lp->head);
+
+    for (int i = 0; i < n; i++) {
+        uint64_t k = key(items + (size_t) i * size);
+        for (int d = 0; d < 8; d++)
+            counts[d][(k >> (d * 8)) & 0xff]++;
+    }
+
+    char* src = items;
+    uint64_t first = key(items);
+    for (int d = 0; d < 8; d++) {
+        if (counts[d][(first >> (d * 8)) & 0xff] == (size_t) n)
+            continue;
+        size_t sum = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = counts[d][b];
+            counts[d][b] = sum;
+            sum += c;
+        }
+        dst = src == items ? scratch : items;
+        if (size == sizeof(int))
+            radixPass(src, dst, n, sizeof(int), key, d * 8, counts[d]);
+        else if (size == sizeof(void*))
+            radixPass(src, dst, n, sizeof(void*), key, d * 8, counts[d]);
+        else
+            radixPass(src, dst, n, size, key, d * 8, counts[d]);
+        src = dst;
+    }
+
+    np = lp->head;
+    do {
+        ringWrite(lp, np, 0, src, np->count);
+        src += (size_t) np->count * size;
+        np = np->next;
+    } while (np != lp->head);
+    scratchFree(lp, scratch, (size_t) n * size);
+    scratchFree(lp, items, (size_t) n * size);
+    free(counts);
+}
+
+/**
+ * Copies a range of items out of the list into a flat buffer, a node at a time.
+ *
+ * @param lp the list to read
+ * @param index the index of the first item
+ * @param items the destination
+ * @param n the number of items
+ * @timeComplexity O(n + log(M)) where M is the number of nodes
+ */
+static void readRange(LIST* lp, int index, char* items, int n) {
+    unsigned offset;
+    if (n == 0)
+        return;
+    int pos = findEntry(lp, index, &offset);
+    while (n > 0) {
+        NODE* np = lp->index[pos++].np;
+        unsigned run = np->count - offset < (unsigned) n ? np->count - offset : (unsigned) n;
+        ringRead(lp, np, offset, items, run);
+        items += (size_t) run * lp->elemSize;
+        n -= run;
+        offset = 0;
+    }
+}
+
+/**
+ * Copies a flat buffer of items over a range of the list, a node at a time.
+ *
+ * @param lp the list to write
+ * @param index the index of the first item
+ * @param items the items to copy
+ * @param n the number of items
+ * @timeComplexity O(n + log(M)) where M is the number of nodes
+ */
+static void writeRange(LIST* lp, int index, const char* items, int n) {
+    unsigned offset;
+    if (n == 0)
+        return;
+    int pos = findEntry(lp, index, &offset);
+    while (n > 0) {
+        NODE* np = lp->index[pos++].np;
+        unsigned run = np->count - offset < (unsigned) n ? np->count - offset : (unsigned) n;
+        ringWrite(lp, np, offset, items, run);
+        items += (size_t) run * lp->elemSize;
+        n -= run;
+        offset = 0;
+    }
+}
+
+#define PARALLEL_SORT_MIN_ITEMS 4096
+
+/*
+ * The state shared by the threads of one parallel sort.  Each thread gets a SORT_TASK naming
+ * the job and its own number.
+ */
+typedef struct sortJob {
+    LIST* lp;
+    int (*cmp)(const void*, const void*);
+    uint64_t (*key)(const void*);
+    int nthreads;
+    int* bounds;             /* start of each thread's segment, plus the item count */
+    int* cuts;               /* start of each part of each segment; nthreads + 1 per segment */
+    char* items;             /* the flat buffer that the items are sorted into */
+    char* scratch;           /* the second buffer for the radix passes */
+    size_t (*digits)[8][256]; /* per-thread counts of every byte of every key */
+    size_t (*counts)[256];   /* per-thread bucket positions for the current radix pass */
+    pthread_barrier_t barrier;
+} SORT_JOB;
+
+typedef struct sortTask {
+    SORT_JOB* job;
+    int id;
+} SORT_TASK;
+
+/**
+ * Runs a function on the given number of threads, the calling thread being the first, and
+ * waits for them all to finish.
+ *
+ * @param job the job whose threads to run
+ * @param fn the function, passed the SORT_TASK of its thread
+ * @timeComplexity O(T) plus the time of the slowest thread, where T is the number of threads
+ */
+static void runSortThreads(SORT_JOB* job, void* (*fn)(void*)) {
+    pthread_t threads[job->nthreads];
+    SORT_TASK tasks[job->nthreads];
+    for (int t = 0; t < job->nthreads; t++) {
+        tasks[t].job = job;
+        tasks[t].id = t;
+        if (t > 0) {
+            int err = pthread_create(&threads[t], NULL, fn, &tasks[t]);
+            assert(err == 0);
+            (void) err;
+        }
+    }
+    fn(&tasks[0]);
+    for (int t = 1; t < job->nthreads; t++)
+        pthread_join(threads[t], NULL);
+}
+
+/**
+ * Divides the list into the given number of segments of about equal length.  A boundary is
+ * moved to the nearest node boundary when one lies within an eighth of a segment, so that
+ * threads sorting neighboring segments rarely share a node; nodes grow geometrically, so the
+ * later boundaries usually fall inside a node.
+ *
+ * @param lp the list to divide
+ * @param nthreads the number of segments
+ * @param bounds set to the start of each segment, followed by the number of items
+ * @timeComplexity O(T log(M)) where T is the number of segments and M is the number of nodes
+ */
+static void segmentList(LIST* lp, int nthreads, int* bounds) {
+    int n = lp->count;
+    long slack = (long) n / nthreads / 8;
+    bounds[0] = 0;
+    for (int t = 1; t < nthreads; t++) {
+        unsigned offset;
+        int target = (long) n * t / nthreads;
+        int pos = findEntry(lp, target, &offset);
+        int before = target - offset;
+        int after = before + lp->index[pos].np->count;
+        if (offset <= slack && offset <= (unsigned) (after - target))
+            target = before;
+        else if (after - target <= slack)
+            target = after;
+        bounds[t] = target < bounds[t - 1] ? bounds[t - 1] : target;
+    }
+    bounds[nthreads] = n;
+}
+
+/**
+ * Sorts one thread's segment of the list in place by introsort.
+ *
+ * @param arg the SORT_TASK of the thread
+ * @return NULL
+ * @timeComplexity O(K log(K)) where K is the length of the segment
+ */
+static void* sortSegment(void* arg) {
+    SORT_TASK* task = arg;
+    SORT_JOB* job = task->job;
+    int lo = job->bounds[task->id], hi = job->bounds[task->id + 1] - 1;
+    if (hi > lo) {
+        int depth = 0;
+        for (int n = hi - lo + 1; n > 1; n /= 2)
+            depth += 2;
+        char* scratch = malloc(2 * job->lp->elemSize);
+        assert(scratch != NULL);
+        introSortRange(job->lp, lo, hi, depth, job->cmp, scratch, scratch + job->lp->elemSize);
+        free(scratch);
+    }
+    return NULL;
+}
+
+/**
+ * Returns the index of the first item in a sorted range of the list that is not less than the
+ * given item.
+ *
+ * @param lp the list to search
+ * @param lo the index of the first item of the range
+ * @param hi the index one past the last item of the range
+ * @param item the address of the item to look for
+ * @param cmp the comparison function
+ * @return the index, which is hi if every item is less
+ * @timeComplexity O(log(K) log(M)) where K is hi - lo and M is the number of nodes
+ */
+static int lowerBound(LIST* lp, int lo, int hi, const void* item, int (*cmp)(const void*, const void*)) {
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (cmp(getItemRef(lp, mid), item) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * Merges one part of every sorted segment into its place in the flat buffer.  The runs are
+ * kept in a binary min-heap keyed on their current items.
+ *
+ * @param arg the SORT_TASK of the thread
+ * @return NULL
+ * @timeComplexity O(K log(T)) where K is the length of the output and T is the number of runs
+ */
+static void* mergeParts(void* arg) {
+    SORT_TASK* task = arg;
+    SORT_JOB* job = task->job;
+    LIST* lp = job->lp;
+    size_t size = lp->elemSize;
+    int nthreads = job->nthreads, t = task->id;
+    LIST_CURSOR cursors[nthreads];
+    int ends[nthreads], heap[nthreads], runs = 0;
+    long out = 0;
+
+    for (int s = 0; s < nthreads; s++) {
+        int* cut = job->cuts + s * (nthreads + 1);
+        for (int u = 0; u < t; u++)
+            out += cut[u + 1] - cut[u];
+        if (cut[t] < cut[t + 1]) {
+            listCursorSeek(&cursors[s], lp, cut[t]);
+            ends[s] = cut[t + 1];
+            heap[runs++] = s;
+        }
+    }
+
+#define RUN_ITEM(s) slotAt(cursors[s].np, cursors[s].offset, size)
+    for (int i = runs / 2 - 1; i >= 0; i--) {
+        for (int k = i, c; (c = 2 * k + 1) < runs; k = c) {
+            if (c + 1 < runs && job->cmp(RUN_ITEM(heap[c + 1]), RUN_ITEM(heap[c])) < 0)
+                c++;
+            if (job->cmp(RUN_ITEM(heap[c]), RUN_ITEM(heap[k])) >= 0)
+                break;
+            int s = heap[k];
+            heap[k] = heap[c];
+            heap[c] = s;
+        }
+    }
+    char* dst = job->items + out * size;
+    while (runs > 0) {
+        int s = heap[0];
+        memcpy(dst, RUN_ITEM(s), size);
+        dst += size;
+        if (cursors[s].index + 1 < ends[s])
+            stepNext(&cursors[s]);
+        else
+            heap[0] = heap[--runs];
+        for (int k = 0, c; (c = 2 * k + 1) < runs; k = c) {
+            if (c + 1 < runs && job->cmp(RUN_ITEM(heap[c + 1]), RUN_ITEM(heap[c])) < 0)
+                c++;
+            if (job->cmp(RUN_ITEM(heap[c]), RUN_ITEM(heap[k])) >= 0)
+                break;
+            int r = heap[k];
+            heap[k] = heap[c];
+            heap[c] = r;
+        }
+    }
+#undef RUN_ITEM
+    return NULL;
+}
+
+/**
+ * Copies one thread's share of the flat buffer back over the list.
+ *
+ * @param arg the SORT_TASK of the thread
+ * @return NULL
+ * @timeComplexity O(K) where K is the length of the share
+ */
+static void* copyBack(void* arg) {
+    SORT_TASK* task = arg;
+    SORT_JOB* job = task->job;
+    int n = job->lp->count;
+    int lo = (long) n * task->id / job->nthreads, hi = (long) n * (task->id + 1) / job->nthreads;
+    writeRange(job->lp, lo, job->items + (size_t) lo * job->lp->elemSize, hi - lo);
+    return NULL;
+}
+
+/**
+ * Sorts the list in place using up to the given number of threads.  The list is divided into
+ * one segment per thread and each thread sorts its segment with introsort.  Sampling the
+ * sorted segments at regular intervals then gives splitters that cut every segment into one
+ * part per thread, and each thread merges the matching parts of all segments into its place
+ * in a flat buffer, which is finally copied back over the list.  Lists too short to be worth
+ * dividing are sorted by listSort.  The comparison function is the same as for listSort and
+ * must be safe to call from several threads at once.
+ *
+ * @param lp the list to sort
+ * @param cmp the comparison function, passed the addresses of two items
+ * @param nthreads the largest number of threads to use
+ * @timeComplexity O((N log(N)) / T + T^2 log(N)) where T is the number of threads
+ */
+void listParallelSort(LIST* lp, int (*cmp)(const void*, const void*), int nthreads) {
+    assert(lp != NULL && cmp != NULL && nthreads > 0);
+    if (nthreads > lp->count / PARALLEL_SORT_MIN_ITEMS)
+        nthreads = lp->count / PARALLEL_SORT_MIN_ITEMS;
+    if (nthreads < 2) {
+        listSort(lp, cmp);
+        return;
+    }
+
+    int n = lp->count;
+    size_t size = lp->elemSize;
+    SORT_JOB job = {.lp = lp, .cmp = cmp, .nthreads = nthreads};
+    job.bounds = malloc((nthreads + 1) * sizeof(int));
+    job.cuts = malloc(nthreads * (nthreads + 1) * sizeof(int));
+    job.items = scratchAlloc(lp, (size_t) n * size);
+    char* samples = malloc((size_t) nthreads * nthreads * size);
+    assert(job.bounds != NULL && job.cuts != NULL && samples != NULL);
+
+    segmentList(lp, nthreads, job.bounds);
+    runSortThreads(&job, sortSegment);
+
+    for (int s = 0; s < nthreads; s++) {
+        int lo = job.bounds[s], len = job.bounds[s + 1] - lo;
+        for (int k = 0; k < nthreads; k++)
+            memcpy(samples + ((size_t) s * nthreads + k) * size,
+                   getItemRef(lp, len > 0 ? lo + (int) ((long) len * k / nthreads) : 0), size);
+    }
+    qsort(samples, (size_t) nthreads * nthreads, size, cmp);
+    for (int s = 0; s < nthreads; s++) {
+        int* cut = job.cuts + s * (nthreads + 1);
+        cut[0] = job.bounds[s];
+        cut[nthreads] = job.bounds[s + 1];
+        for (int k = 1; k < nthreads; k++)
+            cut[k] = lowerBound(lp, cut[k - 1], cut[nthreads],
+                                samples + ((size_t) k * nthreads + nthreads / 2 - 1) * size, cmp);
+    }
+
+    runSortThreads(&job, mergeParts);
+    runSortThreads(&job, copyBack);
+    free(samples);
+    scratchFree(lp, job.items, (size_t) n * size);
+    free(job.cuts);
+    free(job.bounds);
+}
+
+/**
+ * Runs one thread of a parallel radix sort.  The thread copies its share of the list into the
+ * flat buffer and counts every byte of its keys; once all threads have counted, each works out
+ * from the totals which bytes need a pass.  For each pass the threads count their share of the
+ * buckets, the first thread turns the counts into per-thread bucket positions, and every
+ * thread scatters its share.  Barriers separate the steps.
+ *
+ * @param arg the SORT_TASK of the thread
+ * @return NULL
+ * @timeComplexity O(P N / T) where P is the number of passes and T is the number of threads
+ */
+static void* radixWorker(void* arg) {
+    SORT_TASK* task = arg;
+    SORT_JOB* job = task->job;
+    LIST* lp = job->lp;
+    size_t size = lp->elemSize;
+    int n = lp->count, nthreads = job->nthreads, t = task->id;
+    int lo = (long) n * t / nthreads, hi = (long) n * (t + 1) / nthreads;
+    uint64_t (*key)(const void*) = job->key;
+
+    readRange(lp, lo, job->items + (size_t) lo * size, hi - lo);
+    for (int i = lo; i < hi; i++) {
+        uint64_t k = key(job->items + (size_t) i * size);
+        for (int d = 0; d < 8; d++)
+            job->digits[t][d][(k >> (d * 8)) & 0xff]++;
+    }
+    pthread_barrier_wait(&job->barrier);
+
+    char* src = job->items;
+    char* dst = job->scratch;
+    uint64_t first = key(job->items);
+    for (int d = 0; d < 8; d++) {
+        int b = (first >> (d * 8)) & 0xff;
+        size_t same = 0;
+        for (int u = 0; u < nthreads; u++)
+            same += job->digits[u][d][b];
+        if (same == (size_t) n)
+            continue;
+
+        size_t* counts = job->counts[t];
+        memset(counts, 0, sizeof(job->counts[t]));
+        for (int i = lo; i < hi; i++)
+            counts[(key(src + (size_t) i * size) >> (d * 8)) & 0xff]++;
+        pthread_barrier_wait(&job->barrier);
+        if (t == 0) {
+            size_t sum = 0;
+            for (int v = 0; v < 256; v++) {
+                for (int u = 0; u < nthreads; u++) {
+                    size_t c = job->counts[u][v];
+                    job->counts[u][v] = sum;
+                    sum += c;
+                }
+            }
+        }
+        pthread_barrier_wait(&job->barrier);
+        if (size == sizeof(int))
+            radixPass(src + (size_t) lo * size, dst, hi - lo, sizeof(int), key, d * 8, counts);
+        else if (size == sizeof(void*))
+            radixPass(src + (size_t) lo * size, dst, hi - lo, sizeof(void*), key, d * 8, counts);
+        else
+            radixPass(src + (size_t) lo * size, dst, hi - lo, size, key, d * 8, counts);
+        pthread_barrier_wait(&job->barrier);
+        char* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    writeRange(lp, lo, src + (size_t) lo * size, hi - lo);
+    return NULL;
+}
+
+/**
+ * Sorts the list in place by key, as listRadixSort does, using up to the given number of
+ * threads.  Each thread counts and scatters its own share of the items, with its own
+ * histogram, so the only serial work per pass is turning the histograms into bucket
+ * positions.  Lists too short to be worth dividing are sorted by listRadixSort.
+ *
+ * @param lp the list to sort
+ * @param key the key function, passed the address of an item
+ * @param nthreads the largest number of threads to use
+ * @timeComplexity O(N / T + T) per pass where T is the number of threads
+ */
+void listParallelRadixSort(LIST* lp, uint64_t (*key)(const void*), int nthreads) {
+    assert(lp != NULL && key != NULL && nthreads > 0);
+    if (nthreads > lp->count / PARALLEL_SORT_MIN_ITEMS)
+        nthreads = lp->count / PARALLEL_SORT_MIN_ITEMS;
+    if (nthreads < 2) {
+        listRadixSort(lp, key);
+        return;
+    }
+
+    size_t size = lp->elemSize;
+    SORT_JOB job = {.lp = lp, .key = key, .nthreads = nthreads};
+    job.items = scratchAlloc(lp, (size_t) lp->count * size);
+    job.scratch = scratchAlloc(lp, (size_t) lp->count * size);
+    job.digits = calloc(nthreads, sizeof(*job.digits));
+    job.counts = malloc(nthreads * sizeof(*job.counts));
+    assert(job.digits != NULL && job.counts != NULL);
+    pthread_barrier_init(&job.barrier, NULL, nthreads);
+
+    runSortThreads(&job, radixWorker);
+
+    pthread_barrier_destroy(&job.barrier);
+    free(job.counts);
+    free(job.digits);
+    scratchFree(lp, job.scratch, (size_t) lp->count * size);
+    scratchFree(lp, job.items, (size_t) lp->count * size);
+}
+
+#define PARALLEL_EACH_MIN_ITEMS 4096
+
+/*
+ * A set of worker threads kept between calls, so the parallel passes over a list do not create
+ * threads each time.  Every pass hands the workers one task, numbered by round; worker k runs it
+ * as thread k while the calling thread runs it as thread 0, so worker 0 is never started.
+ */
+typedef struct worker {
+    struct listworkers* wp;
+    int id;
+    pthread_t thread;
+} WORKER;
+
+struct listworkers {
+    int nthreads;
+    WORKER* workers;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;     /* signaled when a round starts or the workers must exit */
+    pthread_cond_t idle;     /* signaled when the last worker finishes a round */
+    long round;
+    int busy;
+    bool closing;
+    void (*task)(void* arg, int id);
+    void* arg;
+};
+
+/*
+ * A pass over a list split into ranges of nodes, one per thread.  A pass has exactly one of
+ * the visit, map and keep functions.
+ */
+typedef struct eachJob {
+    LIST* lp;
+    void (*visit)(const void*);
+    void (*map)(void*);
+    bool (*keep)(const void*);
+    int* bounds;             /* index position of each thread's first node, plus the node count */
+} EACH_JOB;
+
+/**
+ * Runs a worker thread, which waits for each round and runs its task until the workers are
+ * destroyed.
+ *
+ * @param arg the worker
+ * @return null
+ * @timeComplexity O(1) per round, plus the time of the task
+ */
+static void* runWorker(void* arg) {
+    WORKER* w = arg;
+    LIST_WORKERS* wp = w->wp;
+    long seen = 0;
+    pthread_mutex_lock(&wp->lock);
+    while (true) {
+        while (wp->round == seen && !wp->closing)
+            pthread_cond_wait(&wp->wake, &wp->lock);
+        if (wp->closing)
+            break;
+        seen = wp->round;
+        pthread_mutex_unlock(&wp->lock);
+        wp->task(wp->arg, w->id);
+        pthread_mutex_lock(&wp->lock);
+        if (--wp->busy == 0)
+            pthread_cond_signal(&wp->idle);
+    }
+    pthread_mutex_unlock(&wp->lock);
+    return NULL;
+}
+
+/**
+ * Creates a set of threads for the parallel passes over lists.  The calling thread of each pass
+ * counts as one of them, so nthreads - 1 threads are started.
+ *
+ * @param nthreads the number of threads each pass uses
+ * @return the new set of workers
+ * @timeComplexity O(nthreads)
+ */
+LIST_WORKERS* createListWorkers(int nthreads) {
+    assert(nthreads > 0);
+    LIST_WORKERS* wp = malloc(sizeof(LIST_WORKERS));
+    assert(wp != NULL);
+    wp->nthreads = nthreads;
+    wp->workers = malloc(nthreads * sizeof(WORKER));
+    assert(wp->workers != NULL);
+    pthread_mutex_init(&wp->lock, NULL);
+    pthread_cond_init(&wp->wake, NULL);
+    pthread_cond_init(&wp->idle, NULL);
+    wp->round = 0;
+    wp->busy = 0;
+    wp->closing = false;
+    for (int t = 1; t < nthreads; t++) {
+        wp->workers[t].wp = wp;
+        wp->workers[t].id = t;
+        int err = pthread_create(&wp->workers[t].thread, NULL, runWorker, &wp->workers[t]);
+        assert(err == 0);
+        (void) err;
+    }
+    return wp;
+}
+
+/**
+ * Stops the threads and frees all memory associated with a set of workers.  No pass may be
+ * using them.
+ *
+ * @param wp the workers to destroy
+ * @timeComplexity O(T) where T is the number of threads
+ */
+void destroyListWorkers(LIST_WORKERS* wp) {
+    assert(wp != NULL);
+    pthread_mutex_lock(&wp->lock);
+    wp->closing = true;
+    pthread_cond_broadcast(&wp->wake);
+    pthread_mutex_unlock(&wp->lock);
+    for (int t = 1; t < wp->nthreads; t++)
+        pthread_join(wp->workers[t].thread, NULL);
+    pthread_cond_destroy(&wp->idle);
+    pthread_cond_destroy(&wp->wake);
+    pthread_mutex_destroy(&wp->lock);
+    free(wp->workers);
+    free(wp);
+}
+
+/**
+ * Runs a task on every thread of a set of workers, the calling thread included, and waits for
+ * all of them to finish it.
+ *
+ * @param wp the workers
+ * @param task the task, passed its argument and the number of the thread running it
+ * @param arg the argument of the task
+ * @timeComplexity O(T) plus the time of the slowest thread, where T is the number of threads
+ */
+static void runWorkers(LIST_WORKERS* wp, void (*task)(void*, int), void* arg) {
+    pthread_mutex_lock(&wp->lock);
+    wp->task = task;
+    wp->arg = arg;
+    wp->busy = wp->nthreads - 1;
+    wp->round++;
+    pthread_cond_broadcast(&wp->wake);
+    pthread_mutex_unlock(&wp->lock);
+    task(arg, 0);
+    pthread_mutex_lock(&wp->lock);
+    while (wp->busy > 0)
+        pthread_cond_wait(&wp->idle, &wp->lock);
+    pthread_mutex_unlock(&wp->lock);
+}
+
+/**
+ * Divides the nodes of a list into consecutive ranges holding about the same number of items,
+ * one per thread.  A range may be empty.
+ *
+ * @param lp the list to divide
+ * @param nthreads the number of ranges
+ * @param bounds where to store the index position of each range's first node, plus the number
+ *        of nodes
+ * @timeComplexity O(nthreads * log(M)) where M is the number of nodes
+ */
+static void segmentNodes(LIST* lp, int nthreads, int* bounds) {
+    bounds[0] = 0;
+    for (int t = 1; t < nthreads; t++) {
+        unsigned offset;
+        int pos = findEntry(lp, (long) lp->count * t / nthreads, &offset);
+        if (offset > lp->index[pos].np->count / 2)
+            pos++;
+        bounds[t] = pos < bounds[t - 1] ? bounds[t - 1] : pos;
+    }
+    bounds[nthreads] = lp->numNodes;
+}
+
+/**
+ * Passes the address of every item of a range of nodes to the job's visit or map function, in
+ * order, a contiguous span at a time.
+ *
+ * @param job the pass
+ * @param from the index position of the first node
+ * @param to the index position after the last node
+ * @timeComplexity O(n) where n is the number of items in the nodes
+ */
+static void visitNodes(EACH_JOB* job, int from, int to) {
+    size_t size = job->lp->elemSize;
+    for (int pos = from; pos < to; pos++) {
+        NODE* np = job->lp->index[pos].np;
+        unsigned first, run = firstSpan(np, &first);
+        char* p = np->data + (size_t) first * size;
+        for (unsigned i = 0; i < np->count; i++, p += size) {
+            if (i == run)
+                p = np->data;
+            if (job->visit != NULL)
+                job->visit(p);
+            else
+                job->map(p);
+        }
+    }
+}
+
+/**
+ * Removes the items of a range of nodes that fail the job's keep function, moving the
+ * survivors of each node toward its first item.  The index and the list's count are left for
+ * dropEmptyNodes to correct.
+ *
+ * @param job the pass
+ * @param from the index position of the first node
+ * @param to the index position after the last node
+ * @timeComplexity O(n) where n is the number of items in the nodes
+ */
+static void filterNodes(EACH_JOB* job, int from, int to) {
+    size_t size = job->lp->elemSize;
+    for (int pos = from; pos < to; pos++) {
+        NODE* np = job->lp->index[pos].np;
+        unsigned first, run = firstSpan(np, &first), kept = 0;
+        char* p = np->data + (size_t) first * size;
+        for (unsigned i = 0; i < np->count; i++, p += size) {
+            if (i == run)
+                p = np->data;
+            if (job->keep(p)) {
+                if (kept != i)
+                    memcpy(slotAt(np, kept, size), p, size);
+                kept++;
+            }
+        }
+        np->count = kept;
+    }
+}
+
+/**
+ * Retires every node that a filter has emptied, keeping one if all are empty, and then
+ * recounts the list and rebuilds its index.
+ *
+ * @param lp the list
+ * @timeComplexity O(M) where M is the number of nodes
+ */
+static void dropEmptyNodes(LIST* lp) {
+    int count = 0;
+    for (int pos = 0; pos < lp->numNodes; pos++)
+        count += lp->index[pos].np->count;
+    lp->count = count;
+    for (int pos = 0; pos < lp->numNodes; pos++) {
+        NODE* np = lp->index[pos].np;
+        if (np->count > 0 || np->next == np)
+            continue;
+        np->prev->next = np->next;
+        np->next->prev = np->prev;
+        if (lp->head == np)
+            lp->head = np->next;
+        retireNode(lp, np);
+    }
+    rebuildIndex(lp);
+}
+
+/**
+ * Runs one thread's share of a parallel pass.
+ *
+ * @param arg the pass
+ * @param id the number of the thread
+ * @timeComplexity O(n) where n is the number of items in the thread's nodes
+ */
+static void eachTask(void* arg, int id) {
+    EACH_JOB* job = arg;
+    if (job->keep != NULL)
+        filterNodes(job, job->bounds[id], job->bounds[id + 1]);
+    else
+        visitNodes(job, job->bounds[id], job->bounds[id + 1]);
+}
+
+/**
+ * Runs a pass over every node of a list on a set of workers, each thread taking a range of
+ * nodes, or on the calling thread alone if the list is too small to be worth dividing.
+ *
+ * @param job the pass
+ * @param wp the workers (can be null to run on the calling thread)
+ * @timeComplexity O(N / T + T log(M)) where T is the number of threads and M the number of nodes
+ */
+static void runEachJob(EACH_JOB* job, LIST_WORKERS* wp) {
+    LIST* lp = job->lp;
+    if (wp == NULL || wp->nthreads < 2 || lp->count < 2 * PARALLEL_EACH_MIN_ITEMS) {
+        int bounds[2] = {0, lp->numNodes};
+        job->bounds = bounds;
+        eachTask(job, 0);
+        return;
+    }
+    int bounds[wp->nthreads + 1];
+    segmentNodes(lp, wp->nthreads, bounds);
+    job->bounds = bounds;
+    runWorkers(wp, eachTask, job);
+}
+
+/**
+ * Passes the address of every item of a list to a function, in order.  Each node's items are
+ * visited in at most two contiguous spans.
+ *
+ * @param lp the list
+ * @param fn the function, which must not change the list
+ * @timeComplexity O(N)
+ */
+void listForEach(LIST* lp, void (*fn)(const void*)) {
+    assert(lp != NULL && fn != NULL);
+    listParallelForEach(lp, fn, NULL);
+}
+
+/**
+ * Passes the address of every item of a list to a function that may rewrite the item in place,
+ * in order.
+ *
+ * @param lp the list
+ * @param fn the function, which may change the item it is passed but not the list
+ * @timeComplexity O(N)
+ */
+void listMapInPlace(LIST* lp, void (*fn)(void*)) {
+    assert(lp != NULL && fn != NULL);
+    listParallelMapInPlace(lp, fn, NULL);
+}
+
+/**
+ * Removes every item of a list for which a predicate, passed the address of the item, is
+ * false.  The survivors keep their order and are compacted within their nodes, and nodes left
+ * empty are retired as by the list's trim policy.  Cursors on the list are invalidated.
+ *
+ * @param lp the list
+ * @param keep the predicate
+ * @return the number of items removed
+ * @timeComplexity O(N)
+ */
+int listFilterInPlace(LIST* lp, bool (*keep)(const void*)) {
+    assert(lp != NULL && keep != NULL);
+    return listParallelFilterInPlace(lp, keep, NULL);
+}
+
+/**
+ * Passes the address of every item of a list to a function, as listForEach does, with each
+ * thread of a set of workers taking a range of nodes.  The items are visited in no particular
+ * order, and the function must be safe to call from several threads at once.
+ *
+ * @param lp the list
+ * @param fn the function, which must not change the list
+ * @param wp the workers (can be null to run on the calling thread)
+ * @timeComplexity O(N / T) where T is the number of threads
+ */
+void listParallelForEach(LIST* lp, void (*fn)(const void*), LIST_WORKERS* wp) {
+    assert(lp != NULL && fn != NULL);
+    EACH_JOB job = {.lp = lp, .visit = fn};
+    runEachJob(&job, wp);
+}
+
+/**
+ * Rewrites every item of a list in place, as listMapInPlace does, with each thread of a set of
+ * workers taking a range of nodes.
+ *
+ * @param lp the list
+ * @param fn the function, which may change the item it is passed but not the list
+ * @param wp the workers (can be null to run on the calling thread)
+ * @timeComplexity O(N / T) where T is the number of threads
+ */
+void listParallelMapInPlace(LIST* lp, void (*fn)(void*), LIST_WORKERS* wp) {
+    assert(lp != NULL && fn != NULL);
+    EACH_JOB job = {.lp = lp, .map = fn};
+    runEachJob(&job, wp);
+}
+
+/**
+ * Removes every item of a list that fails a predicate, as listFilterInPlace does, with each
+ * thread of a set of workers compacting a range of nodes.  The predicate must be safe to call
+ * from several threads at once.
+ *
+ * @param lp the list
+ * @param keep the predicate
+ * @param wp the workers (can be null to run on the calling thread)
+ * @return the number of items removed
+ * @timeComplexity O(N / T + M) where T is the number of threads and M the number of nodes
+ */
+int listParallelFilterInPlace(LIST* lp, bool (*keep)(const void*), LIST_WORKERS* wp) {
+    assert(lp != NULL && keep != NULL);
+    int before = lp->count;
+    EACH_JOB job = {.lp = lp, .keep = keep};
+    runEachJob(&job, wp);
+    dropEmptyNodes(lp);
+    return before - lp->count;
+}
+
+/**
+ * Fills in the statistics of a list.  The node counts and byte totals are always measured;
+ * the allocation counts and the lookup and latency histograms are only kept when the list
+ * code is built with -DLIST_STATS, and are zero otherwise.  Bucket k of the walks histogram
+ * counts lookups whose binary search over the index took k steps; bucket k of the pushes and
+ * pops histograms counts operations that took from 2^k to 2^(k+1) nanoseconds.
+ *
+ * @param lp the list to measure
+ * @param sp the statistics to fill in
+ * @timeComplexity O(M + S) where M is the number of nodes and S is the number of spare nodes
+ */
+void listGetStats(LIST* lp, LIST_STATISTICS* sp) {
+    assert(lp != NULL && sp != NULL);
+#ifdef LIST_STATS
+    *sp = lp->stats;
+#else
+    memset(sp, 0, sizeof(*sp));
+#endif
+    sp->numNodes = lp->numNodes;
+    sp->numSpares = lp->numSpares;
+    sp->bytesUsed = (size_t) lp->count * lp->elemSize;
+    sp->bytesReserved = sizeof(LIST) + lp->maxNodes * sizeof(ENTRY);
+    for (int i = 0; i < lp->numNodes; i++)
+        sp->bytesReserved += NODE_SIZE(lp->index[i].np->capacity, lp->elemSize);
+    for (NODE* np = lp->spares; np != NULL; np = np->next)
+        sp->bytesReserved += NODE_SIZE(np->capacity, lp->elemSize);
+}
+
+/**
+ * Prints one histogram of the statistics, skipping empty buckets.
+ *
+ * @param fp the stream to print to
+ * @param name the name of the histogram
+ * @param histogram the buckets
+ * @param unit the meaning of a bucket number
+ * @timeComplexity O(1)
+ */
+static void dumpHistogram(FILE* fp, const char* name, const long* histogram, const char* unit) {
+    fprintf(fp, "  %s:", name);
+    for (int i = 0; i < LIST_STATS_BUCKETS; i++)
+        if (histogram[i] > 0)
+            fprintf(fp, " [%s%d]=%ld", unit, i, histogram[i]);
+    fprintf(fp, "\n");
+}
+
+/**
+ * Prints the statistics of a list in a readable form.
+ *
+ * @param lp the list to describe
+ * @param fp the stream to print to
+ * @timeComplexity O(M + S) where M is the number of nodes and S is the number of spare nodes
+ */
+void listDumpStats(LIST* lp, FILE* fp) {
+    assert(fp != NULL);
+    LIST_STATISTICS stats;
+    listGetStats(lp, &stats);
+    fprintf(fp, "list %p: %d items in %d nodes, %d spare\n", (void*) lp, lp->count, stats.numNodes,
+            stats.numSpares);
+    fprintf(fp, "  bytes: %zu reserved, %zu used (%.1f%% wasted)\n", stats.bytesReserved, stats.bytesUsed,
+            100.0 * (stats.bytesReserved - stats.bytesUsed) / stats.bytesReserved);
+    if (!stats.counted) {
+        fprintf(fp, "  (build with -DLIST_STATS for allocation, lookup and latency counts)\n");
+        return;
+    }
+    fprintf(fp, "  nodes: %ld allocated, %ld freed\n", stats.nodeAllocs, stats.nodeFrees);
+    dumpHistogram(fp, "lookup steps", stats.walks, "");
+    dumpHistogram(fp, "push ns", stats.pushes, "2^");
+    dumpHistogram(fp, "pop ns", stats.pops, "2^");
+}
+
+#ifdef LIST_STATS
+/**
+ * Returns the current time in nanoseconds, for timing pushes and pops.
+ *
+ * @return the time from a monotonic clock
+ * @timeComplexity O(1)
+ */
+long listStatsClock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/**
+ * Counts an operation that started at the given time in a latency histogram.
+ *
+ * @param histogram the buckets, by log2 of nanoseconds
+ * @param start the time the operation started, from listStatsClock
+ * @timeComplexity O(log(T)) where T is the time taken
+ */
+void listStatsRecord(long* histogram, long start) {
+    long elapsed = listStatsClock() - start;
+    int bucket = 0;
+    while (elapsed > 1 && bucket < LIST_STATS_BUCKETS - 1) {
+        elapsed >>= 1;
+        bucket++;
+    }
+    LIST_STATS_BUMP(histogram[bucket]);
+}
+#endif
+
+/**
+ * Replaces the single node of an empty list with one of the given capacity.
+ *
+ * @param lp the empty list
+ * @param capacity the capacity of the new node
+ * @timeComplexity O(1)
+ */
+static void replaceEmptyHead(LIST* lp, unsigned capacity) {
+    NODE* np = makeNode(lp, capacity, NULL, NULL);
+    np->next = np;
+    np->prev = np;
+    lp->slots += capacity;
+    freeNode(lp, lp->head);
+    lp->head = np;
+    lp->index[0].np = np;
+    lp->index[0].start = 0;
+}
+
+/**
+ * Sets the growth policy of the list.  A node linked at either end holds factor times as many
+ * items as its neighbor, but no node grows beyond maxBytes of items, so a list keeps chaining
+ * nodes of a bounded size instead of allocating one huge array.  Existing nodes are left as
+ * they are, except that an empty list gets a first node of the initial capacity.
+ *
+ * @param lp the list to configure
+ * @param initial the capacity of the first node, rounded up to a power of two
+ * @param factor the growth factor, a power of two (1 keeps every node the same size)
+ * @param maxBytes the largest node data size in bytes, or zero for no limit
+ * @timeComplexity O(log(maxBytes))
+ */
+void listSetGrowth(LIST* lp, unsigned initial, unsigned factor, size_t maxBytes) {
+    assert(lp != NULL);
+    assert(factor >= 1 && (factor & (factor - 1)) == 0);
+    lp->growthFactor = factor;
+    lp->maxCapacity = maxCapacityFor(lp->elemSize, maxBytes);
+    lp->initialCapacity = fitCapacity(initial);
+    if (lp->initialCapacity > lp->maxCapacity)
+        lp->initialCapacity = lp->maxCapacity;
+    if (lp->count == 0 && lp->head->capacity != lp->initialCapacity)
+        replaceEmptyHead(lp, lp->initialCapacity);
+}
+
+/**
+ * Preallocates storage so that n more items can be added at either end of the list without
+ * allocating.  The storage is kept as spare nodes, sized by the growth
+ * policy, which the trim policy may release again: LIST_TRIM_HYSTERESIS frees them on a
+ * removal that leaves the list sparse, and listSetTrimPolicy and listShrinkToFit free them.
+ *
+ * @param lp the list to reserve storage in
+ * @param n the number of items to make room for
+ * @timeComplexity O(n / C + M) where C is the node capacity and M is the number of nodes
+ */
+void listReserve(LIST* lp, int n) {
+    assert(lp != NULL && n >= 0);
+    if (lp->count == 0 && lp->head->capacity < (unsigned) n && lp->head->capacity < lp->maxCapacity)
+        replaceEmptyHead(lp, fitCapacity(n) < lp->maxCapacity ? fitCapacity(n) : lp->maxCapacity);
+    NODE* first = lp->head;
+    NODE* last = first->prev;
+    unsigned firstRoom = first->capacity - first->count;
+    unsigned lastRoom = last->capacity - last->count;
+    long needed = n - (long) (firstRoom < lastRoom ? firstRoom : lastRoom);
+    if (needed <= 0)
+        return;
+    unsigned endCapacity = first->capacity > last->capacity ? first->capacity : last->capacity;
+    unsigned capacity = growCapacity(lp, endCapacity, needed);
+    for (NODE* np = lp->spares; np != NULL; np = np->next)
+        if (np->capacity >= capacity)
+            needed -= np->capacity;
+    for (; needed > 0; needed -= capacity) {
+        lp->spares = makeNode(lp, capacity, lp->spares, NULL);
+        lp->slots += capacity;
+        lp->numSpares++;
+    }
+    indexReserve(lp, lp->numSpares);
+}
+
+/**
+ * Sets the policy used to dispose of nodes drained by removals.  LIST_TRIM_EAGER frees them
+ * at once, LIST_TRIM_SPARE keeps up to param of them for reuse, and LIST_TRIM_HYSTERESIS
+ * keeps them until fewer than 1 / param of the reserved slots are in use.
+ *
+ * @param lp the list to configure
+ * @param policy one of LIST_TRIM_EAGER, LIST_TRIM_SPARE or LIST_TRIM_HYSTERESIS
+ * @param param the number of spare nodes or the hysteresis ratio (ignored when eager)
+ * @timeComplexity O(S) where S is the number of spare nodes
+ */
+void listSetTrimPolicy(LIST* lp, int policy, int param) {
+    assert(lp != NULL);
+    assert(policy == LIST_TRIM_EAGER || policy == LIST_TRIM_SPARE || policy == LIST_TRIM_HYSTERESIS);
+    assert(param >= 0 && (policy != LIST_TRIM_HYSTERESIS || param >= 1));
+    lp->trimPolicy = policy;
+    lp->trimParam = param;
+    while (lp->spares != NULL && (policy == LIST_TRIM_EAGER || lp->numSpares > param)) {
+        NODE* np = lp->spares;
+        lp->spares = np->next;
+        lp->numSpares--;
+        freeNode(lp, np);
+    }
+}
+
+/**
+ * Releases all spare nodes and reallocates every node that is less than a quarter full to the
+ * smallest power of two that holds its items.
+ *
+ * @param lp the list to shrink
+ * @timeComplexity O(N) where N is the number of items
+ */
+void listShrinkToFit(LIST* lp) {
+    assert(lp != NULL);
+    releaseSpares(lp);
+    for (int i = 0; i < lp->numNodes; i++) {
+        NODE* np = lp->index[i].np;
+        if (np->capacity <= DEFAULT_SUBARRAY_LENGTH || np->count > np->capacity / 4)
+            continue;
+        unsigned capacity = fitCapacity(np->count);
+        NODE* copy = makeNode(lp, capacity, np->next, np->prev);
+        ringRead(lp, np, 0, copy->data, np->count);
+        copy->count = np->count;
+        if (np->next == np) {
+            copy->next = copy;
+            copy->prev = copy;
+        } else {
+            np->prev->next = copy;
+            np->next->prev = copy;
+        }
+        if (lp->head == np)
+            lp->head = copy;
+        lp->index[i].np = copy;
+        lp->slots += capacity;
+        freeNode(lp, np);
+    }
+}
+
+/**
+ * Creates a pool that recycles blocks freed through listPoolFree.  Pass listPoolAlloc,
+ * listPoolFree and the pool to createListWithAllocator to share it between lists.
+ *
+ * @return the new pool
+ * @timeComplexity O(1)
+ */
+LIST_POOL* createListPool() {
+    LIST_POOL* pp = calloc(1, sizeof(LIST_POOL));
+    assert(pp != NULL);
+    return pp;
+}
+
+/**
+ * Destroys the pool and frees every block held by it.  Lists using the pool must have been
+ * destroyed first.
+ *
+ * @param pp the pool to destroy
+ * @timeComplexity O(B) where B is the number of free blocks
+ */
+void destroyListPool(LIST_POOL* pp) {
+    assert(pp != NULL);
+    for (int i = 0; i < POOL_CLASSES; i++)
+        while (pp->free[i] != NULL) {
+            BLOCK* bp = pp->free[i];
+            pp->free[i] = bp->next;
+            free(bp);
+        }
+    free(pp);
+}
+
+/**
+ * Finds the class for blocks of the given size, claiming an empty one if needed.
+ *
+ * @param pp the pool to search
+ * @param size the rounded size of the block
+ * @return the class, or -1 if the table is full
+ * @timeComplexity O(1) expected
+ */
+static int poolClass(LIST_POOL* pp, size_t size) {
+    unsigned slot = (size / POOL_ALIGNMENT) % POOL_CLASSES;
+    for (int i = 0; i < POOL_CLASSES; i++) {
+        if (pp->sizes[slot] == size)
+            return slot;
+        if (pp->sizes[slot] == 0) {
+            pp->sizes[slot] = size;
+            return slot;
+        }
+        slot = (slot + 1) % POOL_CLASSES;
+    }
+    return -1;
+}
+
+/**
+ * Allocates a block from the pool, reusing a freed block of the same size if there is one.
+ *
+ * @param ctx the pool
+ * @param size the number of bytes to allocate
+ * @return the block
+ * @timeComplexity O(1) expected
+ */
+void* listPoolAlloc(void* ctx, size_t size) {
+    LIST_POOL* pp = ctx;
+    size = (size + POOL_ALIGNMENT - 1) / POOL_ALIGNMENT * POOL_ALIGNMENT;
+    int c = poolClass(pp, size);
+    if (c >= 0 && pp->free[c] != NULL) {
+        BLOCK* bp = pp->free[c];
+        pp->free[c] = bp->next;
+        return bp;
+    }
+    return malloc(size);
+}
+
+/**
+ * Returns a block to the pool.
+ *
+ * @param ctx the pool
+ * @param ptr the block to free
+ * @param size the size that was passed to listPoolAlloc
+ * @timeComplexity O(1) expected
+ */
+void listPoolFree(void* ctx, void* ptr, size_t size) {
+    LIST_POOL* pp = ctx;
+    size = (size + POOL_ALIGNMENT - 1) / POOL_ALIGNMENT * POOL_ALIGNMENT;
+    int c = poolClass(pp, size);
+    if (c < 0) {
+        free(ptr);
+        return;
+    }
+    BLOCK* bp = ptr;
+    bp->next = pp->free[c];
+    pp->free[c] = bp;
+}
+
+/**
+ * Allocates a block for a list with mapped storage.  Small blocks come from malloc; large ones
+ * are mapped directly, from reserved huge pages if the block is big enough and there are any,
+ * and otherwise on a huge page boundary with transparent huge pages requested.  Pass
+ * listMapAlloc, listMapFree and a null context to createListWithAllocator.
+ *
+ * @param ctx unused
+ * @param size the number of bytes to allocate
+ * @return the block, or null if it cannot be mapped
+ * @timeComplexity O(1)
+ */
+void* listMapAlloc(void* ctx, size_t size) {
+    (void) ctx;
+    if (size < MAP_THRESHOLD)
+        return malloc(size);
+    size_t length = mapLength(size);
+#ifdef MAP_HUGETLB
+    if (length % LIST_HUGE_PAGE_SIZE == 0) {
+        void* p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED)
+            return p;
+    }
+#endif
+    size_t padding = length >= LIST_HUGE_PAGE_SIZE ? LIST_HUGE_PAGE_SIZE : 0;
+    char* p = mmap(NULL, length + padding, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+    char* block = p;
+    if (padding > 0)
+        block = (char*) (((uintptr_t) p + padding - 1) & ~(uintptr_t) (padding - 1));
+    if (block > p)
+        munmap(p, block - p);
+    if (p + length + padding > block + length)
+        munmap(block + length, p + length + padding - (block + length));
+#ifdef MADV_HUGEPAGE
+    madvise(block, length, MADV_HUGEPAGE);
+#endif
+    return block;
+}
+
+/**
+ * Frees a block from listMapAlloc.
+ *
+ * @param ctx unused
+ * @param ptr the block to free
+ * @param size the size that was passed to listMapAlloc
+ * @timeComplexity O(1)
+ */
+void listMapFree(void* ctx, void* ptr, size_t size) {
+    (void) ctx;
+    if (size < MAP_THRESHOLD)
+        free(ptr);
+    else
+        munmap(ptr, mapLength(size));
+}
+
+/**
+ * Creates a new list of items of the given size whose nodes are mapped with listMapAlloc and
+ * grow up to LIST_HUGE_NODE_BYTES, so that a giant list sits on huge pages.
+ *
+ * @param elemSize the size of each item in bytes
+ * @return the new list
+ * @timeComplexity O(1)
+ */
+LIST* createMappedListOfSize(size_t elemSize) {
+    LIST* lp = createListOfSizeWithAllocator(elemSize, listMapAlloc, listMapFree, NULL);
+    listSetGrowth(lp, DEFAULT_SUBARRAY_LENGTH, DEFAULT_GROWTH_FACTOR, LIST_HUGE_NODE_BYTES);
+    return lp;
+}
+
+/**
+ * Returns the space a node of the given capacity takes in a snapshot file.
+ *
+ * @param capacity the capacity of the node
+ * @param elemSize the size of each item in bytes
+ * @return the size of the node rounded up to SNAPSHOT_ALIGNMENT
+ * @timeComplexity O(1)
+ */
+static size_t snapshotStride(unsigned capacity, size_t elemSize) {
+    return (NODE_SIZE(capacity, elemSize) + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+/**
+ * The allocator of a list mapped from a snapshot, which defers to malloc and counts blocks.
+ */
+static void* snapshotAlloc(void* ctx, size_t size) {
+    SNAPSHOT* sp = ctx;
+    sp->blocks++;
+    return malloc(size);
+}
+
+/**
+ * The deallocator of a list mapped from a snapshot.  Nodes in the mapping are left in place,
+ * and the mapping is removed along with the last block.
+ */
+static void snapshotFree(void* ctx, void* ptr, size_t size) {
+    SNAPSHOT* sp = ctx;
+    (void) size;
+    if ((char*) ptr < sp->base || (char*) ptr >= sp->base + sp->length)
+        free(ptr);
+    if (--sp->blocks == 0) {
+        munmap(sp->base, sp->length);
+        free(sp);
+    }
+}
+
+/**
+ * Saves a list to a snapshot file that listMap can map back in.  The file holds the items by
+ * value, so it is only meaningful for items that hold no pointers, and only on a machine with
+ * the same byte order and node layout.
+ *
+ * @param lp the list to save
+ * @param path the name of the file to write
+ * @return true if the file was written, false on an I/O error
+ * @timeComplexity O(N)
+ */
+bool listSave(LIST* lp, const char* path) {
+    assert(lp != NULL && path != NULL);
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL)
+        return false;
+    size_t size = lp->elemSize;
+    unsigned capacity = maxCapacityFor(size, LIST_HUGE_NODE_BYTES);
+    char* page = calloc(1, SNAPSHOT_ALIGNMENT);
+    NODE* block = malloc(snapshotStride(capacity, size));
+    assert(page != NULL && block != NULL);
+
+    SNAPSHOT_HEADER header = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, SNAPSHOT_BYTE_ORDER, sizeof(NODE), capacity,
+                              size, lp->count, (lp->count + (long) capacity - 1) / capacity};
+    memcpy(page, &header, sizeof(header));
+    bool ok = fwrite(page, SNAPSHOT_ALIGNMENT, 1, fp) == 1;
+
+    for (int start = 0; ok && start < lp->count; start += capacity) {
+        unsigned left = lp->count - start;
+        unsigned k = left < capacity ? left : capacity;
+        unsigned blockCapacity = k < capacity ? fitCapacity(k) : capacity;
+        size_t stride = snapshotStride(blockCapacity, size);
+        memset(block, 0, sizeof(NODE));
+        block->count = k;
+        block->capacity = blockCapacity;
+        block->mask = blockCapacity - 1;
+        readRange(lp, start, block->data, k);
+        memset(block->data + (size_t) k * size, 0, stride - NODE_SIZE(k, size));
+        ok = fwrite(block, stride, 1, fp) == 1;
+    }
+
+    free(block);
+    free(page);
+    return fclose(fp) == 0 && ok;
+}
+
+/**
+ * Checks that a snapshot file of the given length holds the nodes its header describes, laid
+ * out as listSave writes them.
+ *
+ * @param base the start of the mapped file
+ * @param length the length of the file
+ * @return true if the snapshot can be used
+ * @timeComplexity O(M) where M is the number of nodes
+ */
+static bool validSnapshot(const char* base, size_t length) {
+    const SNAPSHOT_HEADER* hp = (const SNAPSHOT_HEADER*) base;
+    if (length < SNAPSHOT_ALIGNMENT || memcmp(hp->magic, SNAPSHOT_MAGIC, sizeof(hp->magic)) != 0 ||
+        hp->version != SNAPSHOT_VERSION || hp->byteOrder != SNAPSHOT_BYTE_ORDER ||
+        hp->nodeHeader != sizeof(NODE) || hp->elemSize == 0 || hp->count > INT_MAX ||
+        hp->blockCapacity == 0 || (hp->blockCapacity & (hp->blockCapacity - 1)) != 0)
+        return false;
+    size_t offset = SNAPSHOT_ALIGNMENT;
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < hp->numNodes; i++) {
+        if (length - offset < sizeof(NODE))
+            return false;
+        const NODE* np = (const NODE*) (base + offset);
+        if (np->capacity == 0 || (np->capacity & (np->capacity - 1)) != 0 ||
+            np->capacity > hp->blockCapacity || np->mask != np->capacity - 1 ||
+            np->firstIndex != 0 || np->count == 0 || np->count > np->capacity ||
+            length - offset < snapshotStride(np->capacity, hp->elemSize))
+            return false;
+        count += np->count;
+        offset += snapshotStride(np->capacity, hp->elemSize);
+    }
+    return count == hp->count;
+}
+
+/**
+ * Maps a snapshot file written by listSave as a list of items by value.  The items are not
+ * read or copied: the nodes are used in place, paged in from the file as they are touched, and
+ * the list can be changed like any other, with the pages it writes copied privately.  The file
+ * itself is never modified.
+ *
+ * @param path the name of the file to map
+ * @return the new list, or null if the file cannot be read or is not a valid snapshot
+ * @timeComplexity O(M) where M is the number of nodes
+ */
+LIST* listMap(const char* path) {
+    assert(path != NULL);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    char* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= SNAPSHOT_ALIGNMENT)
+        base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return NULL;
+    if (!validSnapshot(base, st.st_size)) {
+        munmap(base, st.st_size);
+        return NULL;
+    }
+
+    const SNAPSHOT_HEADER* hp = (const SNAPSHOT_HEADER*) base;
+    SNAPSHOT* sp = malloc(sizeof(SNAPSHOT));
+    assert(sp != NULL);
+    sp->base = base;
+    sp->length = st.st_size;
+    sp->blocks = hp->numNodes;
+    LIST* lp = createListOfSizeWithAllocator(hp->elemSize, snapshotAlloc, snapshotFree, sp);
+    if (hp->numNodes == 0)
+        return lp;
+
+    freeNode(lp, lp->head);
+    lp->head = (NODE*) (base + SNAPSHOT_ALIGNMENT);
+    NODE* np = lp->head;
+    for (uint64_t i = 0; i < hp->numNodes; i++) {
+        NODE* next = (NODE*) ((char*) np + snapshotStride(np->capacity, hp->elemSize));
+        if (i == hp->numNodes - 1)
+            next = lp->head;
+        np->next = next;
+        next->prev = np;
+        lp->slots += np->capacity;
+        np = next;
+    }
+    lp->count = hp->count;
+    rebuildIndex(lp);
+    return lp;
+}
+
+/**
+ * Tells the system how the mapped nodes of a list are about to be accessed: LIST_ADVISE_NORMAL,
+ * LIST_ADVISE_SEQUENTIAL before a pass over the whole list, or LIST_ADVISE_RANDOM before
+ * scattered lookups.  For a list mapped by listMap the advice covers the whole file, which
+ * steers read-ahead; other nodes that are not mapped are left alone.
+ *
+ * @param lp the list
+ * @param advice one of LIST_ADVISE_NORMAL, LIST_ADVISE_SEQUENTIAL or LIST_ADVISE_RANDOM
+ * @timeComplexity O(M) where M is the number of nodes
+ */
+void listAdvise(LIST* lp, int advice) {
+    assert(lp != NULL);
+    assert(advice == LIST_ADVISE_NORMAL || advice == LIST_ADVISE_SEQUENTIAL || advice == LIST_ADVISE_RANDOM);
+    int flag = advice == LIST_ADVISE_SEQUENTIAL ? MADV_SEQUENTIAL :
+               advice == LIST_ADVISE_RANDOM ? MADV_RANDOM : MADV_NORMAL;
+    if (lp->alloc == snapshotAlloc) {
+        SNAPSHOT* sp = lp->ctx;
+        madvise(sp->base, sp->length, flag);
+    } else if (lp->alloc == listMapAlloc) {
+        for (int i = 0; i < lp->numNodes; i++) {
+            size_t size = NODE_SIZE(lp->index[i].np->capacity, lp->elemSize);
+            if (size >= MAP_THRESHOLD)
+                madvise(lp->index[i].np, mapLength(size), flag);
+        }
+    }
+}
 
 /*
 
@@ -7,16 +7,82 @@
  *		declarations for a list abstract data type for generic
  *		pointer types.  The list supports deque operations, in
  *		which items can be easily added to or removed from the
- *		front or rear of the list, as well as indexing.
+ *		front or rear of the list, as well as indexing.  A list
+ *		created with createListOfSize instead stores fixed-size
+ *		items by value and is used through the Value and Ref
+ *		functions.
  */
 
 # ifndef LIST_H
 # define LIST_H
 
+# include <stdio.h>
+# include <stddef.h>
+# include <stdbool.h>
+# include <stdint.h>
+
 typedef struct list LIST;
 
+typedef struct listpool LIST_POOL;
+
+typedef struct listworkers LIST_WORKERS;
+
+typedef void *(*LIST_ALLOC)(void *ctx, size_t size);
+
+typedef void (*LIST_FREE)(void *ctx, void *ptr, size_t size);
+
+typedef struct cursor {		/* fields are private to list.c */
+    LIST *lp;
+    struct node *np;
+    int pos;
+    unsigned offset;
+    int index;
+} LIST_CURSOR;
+
+/*
+ * The counts kept by a -DLIST_STATS build are updated with relaxed atomic
+ * adds, so lookups made by several threads at once, as in the parallel
+ * sorts, are all counted.  They are exact once the threads have finished.
+ */
+
+# define LIST_STATS_BUCKETS	32
+
+typedef struct liststatistics {	/* filled in by listGetStats */
+    bool counted;		/* built with -DLIST_STATS */
+    int numNodes;		/* nodes holding items */
+    int numSpares;		/* drained nodes kept for reuse */
+    size_t bytesReserved;	/* bytes held by the list, index and nodes */
+    size_t bytesUsed;		/* bytes of items */
+    long nodeAllocs;		/* nodes allocated */
+    long nodeFrees;		/* nodes freed */
+    long walks[LIST_STATS_BUCKETS];	/* lookups by number of search steps */
+    long pushes[LIST_STATS_BUCKETS];	/* adds by log2 of nanoseconds taken */
+    long pops[LIST_STATS_BUCKETS];	/* removes by log2 of nanoseconds */
+} LIST_STATISTICS;
+
+# define LIST_TRIM_EAGER	0	/* free drained nodes at once */
+# define LIST_TRIM_SPARE	1	/* keep up to N drained nodes for reuse */
+# define LIST_TRIM_HYSTERESIS	2	/* keep them until usage drops below 1/N */
+
+# define LIST_ADVISE_NORMAL	0	/* no particular access pattern */
+# define LIST_ADVISE_SEQUENTIAL	1	/* a pass over the whole list */
+# define LIST_ADVISE_RANDOM	2	/* scattered lookups */
+
+# define LIST_HUGE_PAGE_SIZE	(2 * 1024 * 1024)
+# define LIST_HUGE_NODE_BYTES	(4 * LIST_HUGE_PAGE_SIZE)	/* mapped lists */
+
 extern LIST *createList(void);
 
+extern LIST *createListWithCapacity(int n);
+
+extern LIST *createListWithAllocator(LIST_ALLOC alloc, LIST_FREE release, void *ctx);
+
+extern LIST *createListOfSize(size_t elemSize);
+
+extern LIST *createListOfSizeWithAllocator(size_t elemSize, LIST_ALLOC alloc, LIST_FREE release, void *ctx);
+
+extern LIST *createMappedListOfSize(size_t elemSize);
+
 extern void destroyList(LIST *lp);
 
 extern int numItems(LIST *lp);
@@ -37,4 +103,120 @@ extern void *getItem(LIST *lp, int index);
 
 extern void setItem(LIST *lp, int index, void *item);
 
+extern void addAt(LIST *lp, int index, void *item);
+
+extern void *removeAt(LIST *lp, int index);
+
+extern void addFirstValue(LIST *lp, const void *elem);
+
+extern void addLastValue(LIST *lp, const void *elem);
+
+extern void removeFirstValue(LIST *lp, void *out);
+
+extern void removeLastValue(LIST *lp, void *out);
+
+extern void *getFirstRef(LIST *lp);
+
+extern void *getLastRef(LIST *lp);
+
+extern void *getItemRef(LIST *lp, int index);
+
+extern void addAtValue(LIST *lp, int index, const void *elem);
+
+extern void removeAtValue(LIST *lp, int index, void *out);
+
+extern void addFirstN(LIST *lp, const void *items, int n);
+
+extern void addLastN(LIST *lp, const void *items, int n);
+
+extern void removeFirstN(LIST *lp, void *out, int n);
+
+extern void removeLastN(LIST *lp, void *out, int n);
+
+extern void listConcat(LIST *dst, LIST *src);
+
+extern LIST *listSplitAt(LIST *lp, int index);
+
+extern void listRotate(LIST *lp, int k);
+
+extern void listCursorSeek(LIST_CURSOR *cp, LIST *lp, int index);
+
+extern bool listCursorNext(LIST_CURSOR *cp);
+
+extern bool listCursorPrev(LIST_CURSOR *cp);
+
+extern void *listCursorGet(LIST_CURSOR *cp);
+
+extern void listCursorSet(LIST_CURSOR *cp, void *item);
+
+extern void *listCursorRef(LIST_CURSOR *cp);
+
+extern void *listCursorRemove(LIST_CURSOR *cp);
+
+extern void listCursorRemoveValue(LIST_CURSOR *cp, void *out);
+
+extern int listCursorIndex(LIST_CURSOR *cp);
+
+extern int listIndexOf(LIST *lp, void *item);
+
+extern int listLastIndexOf(LIST *lp, void *item);
+
+extern int listCount(LIST *lp, void *item);
+
+extern int listFindIf(LIST *lp, bool (*pred)(const void *));
+
+extern void listSort(LIST *lp, int (*cmp)(const void *, const void *));
+
+extern void listRadixSort(LIST *lp, uint64_t (*key)(const void *));
+
+extern void listParallelSort(LIST *lp, int (*cmp)(const void *, const void *), int nthreads);
+
+extern void listParallelRadixSort(LIST *lp, uint64_t (*key)(const void *), int nthreads);
+
+extern void listForEach(LIST *lp, void (*fn)(const void *));
+
+extern void listMapInPlace(LIST *lp, void (*fn)(void *));
+
+extern int listFilterInPlace(LIST *lp, bool (*keep)(const void *));
+
+extern LIST_WORKERS *createListWorkers(int nthreads);
+
+extern void destroyListWorkers(LIST_WORKERS *wp);
+
+extern void listParallelForEach(LIST *lp, void (*fn)(const void *), LIST_WORKERS *wp);
+
+extern void listParallelMapInPlace(LIST *lp, void (*fn)(void *), LIST_WORKERS *wp);
+
+extern int listParallelFilterInPlace(LIST *lp, bool (*keep)(const void *), LIST_WORKERS *wp);
+
+extern void listGetStats(LIST *lp, LIST_STATISTICS *sp);
+
+extern void listDumpStats(LIST *lp, FILE *fp);
+
+extern void listSetGrowth(LIST *lp, unsigned initial, unsigned factor, size_t maxBytes);
+
+extern void listReserve(LIST *lp, int n);
+
+extern void listSetTrimPolicy(LIST *lp, int policy, int param);
+
+extern void listShrinkToFit(LIST *lp);
+
+extern void listAdvise(LIST *lp, int advice);
+
+extern bool listSave(LIST *lp, const char *path);
+
+extern LIST *listMap(const char *path);
+
+extern LIST_POOL *createListPool(void);
+
+extern void destroyListPool(LIST_POOL *pp);
+
+extern void *listPoolAlloc(void *ctx, size_t size);
+
+extern void listPoolFree(void *ctx, void *ptr, size_t size);
+
+extern void *listMapAlloc(void *ctx, size_t size);
+
+extern void listMapFree(void *ctx, void *ptr, size_t size);
+
 # endif /* LIST_H */
@@ -0,0 +1,103 @@
+/*
+ * File:	listnode.h
+ *
+ * Description:	This file contains the layout of a list and of its nodes.
+ *		It is private to the list implementation: it is shared by
+ *		list.c and by the type-specialized lists of listtype.h,
+ *		whose inline fast paths work on the same nodes and fall
+ *		back to the functions declared here.
+ *
+ *		When built with -DLIST_STATS, every list also counts its
+ *		node allocations, lookups, and the time taken by each add
+ *		and remove at either end.  The counters are bumped with
+ *		relaxed atomic adds, since the parallel sorts look items
+ *		up from several threads at once.  The flag changes the
+ *		layout of a list, so everything using lists must be built
+ *		with the same setting.  Without it, the counting compiles
+ *		to nothing.
+ */
+
+# ifndef LISTNODE_H
+# define LISTNODE_H
+
+# include "list.h"
+
+struct list {
+    int count;
+    struct node* head;
+    struct entry* entries;
+    struct entry* index;
+    int numNodes;
+    int maxNodes;
+    struct node* spares;
+    int numSpares;
+    long slots;
+    int trimPolicy;
+    int trimParam;
+    size_t elemSize;
+    unsigned initialCapacity;
+    unsigned growthFactor;
+    unsigned maxCapacity;
+    LIST_ALLOC alloc;
+    LIST_FREE release;
+    void* ctx;
+# ifdef LIST_STATS
+    LIST_STATISTICS stats;
+# endif
+};
+
+# ifdef LIST_STATS
+extern long listStatsClock(void);
+
+extern void listStatsRecord(long* histogram, long start);
+
+# define LIST_STATS_BUMP(counter)	__atomic_fetch_add(&(counter), 1, __ATOMIC_RELAXED)
+# define LIST_STATS_START()		long statsStart = listStatsClock()
+# define LIST_STATS_END(lp, which)	listStatsRecord((lp)->stats.which, statsStart)
+# define LIST_STATS_COUNT(lp, field)	LIST_STATS_BUMP((lp)->stats.field)
+# else
+# define LIST_STATS_START()		((void) 0)
+# define LIST_STATS_END(lp, which)	((void) 0)
+# define LIST_STATS_COUNT(lp, field)	((void) 0)
+# endif
+
+/*
+ * A node is a single allocation holding its header and a ring buffer whose
+ * capacity is always a power of two, so ring positions are reduced with
+ * "& mask" rather than "% capacity".  Items are stored by value, elemSize
+ * bytes each; a list created by createList stores void pointers.
+ */
+typedef struct node {
+    unsigned firstIndex;
+    unsigned count;
+    unsigned capacity;
+    unsigned mask;
+    struct node* next;
+    struct node* prev;
+    char data[];
+} NODE;
+
+# define NODE_SIZE(capacity, elemSize) (sizeof(NODE) + (size_t) (capacity) * (elemSize))
+
+_Static_assert(sizeof(NODE) % _Alignof(max_align_t) == 0, "node data must be aligned for any type");
+
+/*
+ * The index is a directory of the nodes in list order.  Each entry records
+ * the absolute position of the first element of its node, so that for every
+ * entry start[k + 1] == start[k] + count[k].  Logical index i lives at
+ * absolute position start[0] + i, which is found by binary search.  The
+ * index is kept inside a larger buffer with room at both ends so that nodes
+ * can be added or removed at either end in constant time.
+ */
+typedef struct entry {
+    long start;
+    NODE* np;
+} ENTRY;
+
+extern void listGrowFirst(LIST *lp);
+
+extern void listGrowLast(LIST *lp);
+
+extern void listReleaseNode(LIST *lp, int pos);
+
+# endif /* LISTNODE_H */
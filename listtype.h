@@ -0,0 +1,196 @@
+/*
+ * File:	listtype.h
+ *
+ * Description:	This file contains the DEFINE_LIST macro, which generates a
+ *		list specialized for a single item type.  For example,
+ *		DEFINE_LIST(int, int) defines the type LIST_int and the
+ *		functions createList_int, createListWithCapacity_int,
+ *		createMappedList_int, createListWithAllocator_int,
+ *		destroyList_int, numItems_int, addFirst_int, addLast_int,
+ *		removeFirst_int, removeLast_int, getFirst_int, getLast_int,
+ *		getItem_int, setItem_int, addAt_int, removeAt_int,
+ *		addLastN_int, removeFirstN_int and asList_int.
+ *
+ *		A LIST_int is an ordinary list created by createListOfSize
+ *		and uses the same nodes, so asList_int may be used to pass
+ *		it to any function in list.h.  The push and pop functions
+ *		are inlined and work on the nodes directly, with no void
+ *		pointer casts and no multiplication by a run-time item
+ *		size; only the growth and release of nodes are calls.
+ */
+
+# ifndef LISTTYPE_H
+# define LISTTYPE_H
+
+# include <assert.h>
+# include "list.h"
+# include "listnode.h"
+
+# define DEFINE_LIST(name, type)					      \
+									      \
+typedef struct list_##name LIST_##name;					      \
+									      \
+static inline LIST *asList_##name(LIST_##name *tp)			      \
+{									      \
+    return (LIST *) tp;							      \
+}									      \
+									      \
+static inline LIST_##name *createList_##name(void)			      \
+{									      \
+    return (LIST_##name *) createListOfSize(sizeof(type));		      \
+}									      \
+									      \
+static inline LIST_##name *createListWithCapacity_##name(int n)		      \
+{									      \
+    LIST *lp = createListOfSize(sizeof(type));				      \
+									      \
+    listReserve(lp, n);							      \
+    return (LIST_##name *) lp;						      \
+}									      \
+									      \
+static inline LIST_##name *createMappedList_##name(void)		      \
+{									      \
+    return (LIST_##name *) createMappedListOfSize(sizeof(type));	      \
+}									      \
+									      \
+static inline LIST_##name *createListWithAllocator_##name(LIST_ALLOC alloc,  \
+	LIST_FREE release, void *ctx)					      \
+{									      \
+    return (LIST_##name *)						      \
+	createListOfSizeWithAllocator(sizeof(type), alloc, release, ctx);     \
+}									      \
+									      \
+static inline void destroyList_##name(LIST_##name *tp)			      \
+{									      \
+    destroyList((LIST *) tp);						      \
+}									      \
+									      \
+static inline int numItems_##name(LIST_##name *tp)			      \
+{									      \
+    return ((LIST *) tp)->count;					      \
+}									      \
+									      \
+static inline void addFirst_##name(LIST_##name *tp, type item)		      \
+{									      \
+    LIST *lp = (LIST *) tp;						      \
+    NODE *np;								      \
+    LIST_STATS_START();							      \
+									      \
+    if (lp->head->count == lp->head->capacity)				      \
+	listGrowFirst(lp);						      \
+									      \
+    np = lp->head;							      \
+    np->firstIndex = (np->firstIndex - 1) & np->mask;			      \
+    ((type *) np->data)[np->firstIndex] = item;				      \
+    np->count ++;							      \
+    lp->index[0].start --;						      \
+    lp->count ++;							      \
+    LIST_STATS_END(lp, pushes);						      \
+}									      \
+									      \
+static inline void addLast_##name(LIST_##name *tp, type item)		      \
+{									      \
+    LIST *lp = (LIST *) tp;						      \
+    NODE *np;								      \
+    LIST_STATS_START();							      \
+									      \
+    if (lp->head->prev->count == lp->head->prev->capacity)		      \
+	listGrowLast(lp);						      \
+									      \
+    np = lp->head->prev;						      \
+    ((type *) np->data)[(np->firstIndex + np->count) & np->mask] = item;     \
+    np->count ++;							      \
+    lp->count ++;							      \
+    LIST_STATS_END(lp, pushes);						      \
+}									      \
+									      \
+static inline type removeFirst_##name(LIST_##name *tp)			      \
+{									      \
+    LIST *lp = (LIST *) tp;						      \
+    NODE *np = lp->head;						      \
+    type item;								      \
+    LIST_STATS_START();							      \
+									      \
+    assert(lp->count > 0);						      \
+    item = ((type *) np->data)[np->firstIndex];				      \
+    np->firstIndex = (np->firstIndex + 1) & np->mask;			      \
+    np->count --;							      \
+    lp->index[0].start ++;						      \
+    lp->count --;							      \
+									      \
+    if (np->count == 0 && np->next != np)				      \
+	listReleaseNode(lp, 0);						      \
+									      \
+    LIST_STATS_END(lp, pops);						      \
+    return item;							      \
+}									      \
+									      \
+static inline type removeLast_##name(LIST_##name *tp)			      \
+{									      \
+    LIST *lp = (LIST *) tp;						      \
+    NODE *np = lp->head->prev;						      \
+    type item;								      \
+    LIST_STATS_START();							      \
+									      \
+    assert(lp->count > 0);						      \
+    np->count --;							      \
+    lp->count --;							      \
+    item = ((type *) np->data)[(np->firstIndex + np->count) & np->mask];     \
+									      \
+    if (np->count == 0 && np != lp->head)				      \
+	listReleaseNode(lp, lp->numNodes - 1);				      \
+									      \
+    LIST_STATS_END(lp, pops);						      \
+    return item;							      \
+}									      \
+									      \
+static inline type getFirst_##name(LIST_##name *tp)			      \
+{									      \
+    NODE *np = ((LIST *) tp)->head;					      \
+									      \
+    assert(((LIST *) tp)->count > 0);					      \
+    return ((type *) np->data)[np->firstIndex];				      \
+}									      \
+									      \
+static inline type getLast_##name(LIST_##name *tp)			      \
+{									      \
+    NODE *np = ((LIST *) tp)->head->prev;				      \
+									      \
+    assert(((LIST *) tp)->count > 0);					      \
+    return ((type *) np->data)[(np->firstIndex + np->count - 1) & np->mask]; \
+}									      \
+									      \
+static inline type getItem_##name(LIST_##name *tp, int index)		      \
+{									      \
+    return *(type *) getItemRef((LIST *) tp, index);			      \
+}									      \
+									      \
+static inline void setItem_##name(LIST_##name *tp, int index, type item)     \
+{									      \
+    *(type *) getItemRef((LIST *) tp, index) = item;			      \
+}									      \
+									      \
+static inline void addAt_##name(LIST_##name *tp, int index, type item)	      \
+{									      \
+    addAtValue((LIST *) tp, index, &item);				      \
+}									      \
+									      \
+static inline type removeAt_##name(LIST_##name *tp, int index)		      \
+{									      \
+    type item;								      \
+									      \
+    removeAtValue((LIST *) tp, index, &item);				      \
+    return item;							      \
+}									      \
+									      \
+static inline void addLastN_##name(LIST_##name *tp, const type *items, int n) \
+{									      \
+    addLastN((LIST *) tp, items, n);					      \
+}									      \
+									      \
+static inline void removeFirstN_##name(LIST_##name *tp, type *out, int n)    \
+{									      \
+    removeFirstN((LIST *) tp, out, n);					      \
+}
+
+# endif /* LISTTYPE_H */
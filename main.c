@@ -1,6 +1,13 @@
 #include <stdio.h>
 #include <assert.h>
 #include "list.c"
+#include "listtype.h"
+#include "queue.c"
+#include "deque.c"
+#include "arena.c"
+#include "fastio.c"
+
+DEFINE_LIST(int, int)
 
 void testCreateDestroyList() {
     LIST* list = createList();
@@ -85,6 +92,1036 @@ void testGetSetItem() {
     destroyList(list);
 }
 
+void testGetSetItemManyNodes() {
+    LIST* list = createList();
+    int items[1000];
+
+    for (int i = 0; i < 1000; i++) {
+        items[i] = i;
+        if (i % 2 == 0)
+            addLast(list, &items[i]);
+        else
+            addFirst(list, &items[i]);
+    }
+    for (int i = 0; i < 100; i++) {
+        removeFirst(list);
+        removeLast(list);
+    }
+
+    // Odd values were added at the front in reverse, even values at the rear
+    for (int i = 0; i < numItems(list); i++) {
+        int expected = i < 400 ? 799 - 2 * i : 2 * (i - 400);
+        assert(*(int*) getItem(list, i) == expected);
+    }
+
+    setItem(list, 500, &items[0]);
+    assert(*(int*) getItem(list, 500) == 0);
+
+    destroyList(list);
+}
+
+void testTrimPolicies() {
+    int policies[3] = {LIST_TRIM_EAGER, LIST_TRIM_SPARE, LIST_TRIM_HYSTERESIS};
+    int items[1000];
+
+    for (int p = 0; p < 3; p++) {
+        LIST* list = createList();
+        listSetTrimPolicy(list, policies[p], 2);
+
+        // Grow and drain from both ends twice so spare nodes get reused
+        for (int round = 0; round < 2; round++) {
+            for (int i = 0; i < 1000; i++) {
+                items[i] = i;
+                addLast(list, &items[i]);
+            }
+            for (int i = 0; i < 500; i++)
+                assert(*(int*) removeFirst(list) == i);
+            assert(*(int*) getFirst(list) == 500);
+            for (int i = 999; i >= 500; i--)
+                assert(*(int*) removeLast(list) == i);
+            assert(numItems(list) == 0);
+            assert(list->numNodes == 1);
+        }
+
+        listShrinkToFit(list);
+        assert(list->spares == NULL);
+        assert(list->slots == list->head->capacity);
+        addFirst(list, &items[7]);
+        assert(*(int*) getLast(list) == 7);
+        destroyList(list);
+    }
+}
+
+void testPoolAllocator() {
+    LIST_POOL* pool = createListPool();
+    int items[100];
+
+    for (int round = 0; round < 3; round++) {
+        LIST* list = createListWithAllocator(listPoolAlloc, listPoolFree, pool);
+        for (int i = 0; i < 100; i++) {
+            items[i] = i;
+            addLast(list, &items[i]);
+        }
+        for (int i = 0; i < 100; i++)
+            assert(*(int*) getItem(list, i) == i);
+        destroyList(list);
+    }
+
+    destroyListPool(pool);
+}
+
+void testCursor() {
+    LIST* list = createList();
+    LIST_CURSOR cursor;
+    int items[300];
+
+    for (int i = 0; i < 300; i++) {
+        items[i] = i;
+        addLast(list, &items[i]);
+    }
+
+    // Forward and backward traversal across node boundaries
+    listCursorSeek(&cursor, list, 0);
+    for (int i = 0; i < 300; i++) {
+        assert(*(int*) listCursorGet(&cursor) == i);
+        assert(listCursorNext(&cursor) == (i < 299));
+    }
+    assert(listCursorPrev(&cursor));
+    for (int i = 299; i >= 0; i--) {
+        assert(listCursorIndex(&cursor) == i);
+        assert(*(int*) listCursorGet(&cursor) == i);
+        assert(listCursorPrev(&cursor) == (i > 0));
+    }
+
+    // Remove every odd item, which drains some nodes entirely
+    listCursorSeek(&cursor, list, 1);
+    while (listCursorIndex(&cursor) < numItems(list)) {
+        assert(*(int*) listCursorRemove(&cursor) % 2 == 1);
+        if (listCursorIndex(&cursor) < numItems(list))
+            listCursorNext(&cursor);
+    }
+    assert(numItems(list) == 150);
+    for (int i = 0; i < 150; i++)
+        assert(*(int*) getItem(list, i) == 2 * i);
+
+    listCursorSeek(&cursor, list, 10);
+    listCursorSet(&cursor, &items[1]);
+    assert(*(int*) getItem(list, 10) == 1);
+
+    destroyList(list);
+}
+
+void testBulk() {
+    LIST* list = createList();
+    int items[1000];
+    void* in[1000];
+    void* out[1000];
+
+    for (int i = 0; i < 1000; i++) {
+        items[i] = i;
+        in[i] = &items[i];
+    }
+
+    // Front half added in order at the front, back half appended
+    addLastN(list, in + 500, 3);
+    addLastN(list, in + 503, 497);
+    addFirstN(list, in + 497, 3);
+    addFirstN(list, in, 497);
+    assert(numItems(list) == 1000);
+    for (int i = 0; i < 1000; i++)
+        assert(*(int*) getItem(list, i) == i);
+
+    removeFirstN(list, out, 300);
+    for (int i = 0; i < 300; i++)
+        assert(*(int*) out[i] == i);
+    removeLastN(list, out, 300);
+    for (int i = 0; i < 300; i++)
+        assert(*(int*) out[i] == 700 + i);
+    assert(*(int*) getFirst(list) == 300);
+    assert(*(int*) getLast(list) == 699);
+
+    removeFirstN(list, out, 400);
+    assert(numItems(list) == 0);
+    addLastN(list, in, 2);
+    assert(*(int*) removeLast(list) == 1);
+
+    destroyList(list);
+}
+
+long heldSlots(LIST* lp) {
+    long slots = 0;
+    NODE* np = lp->head;
+    do {
+        slots += np->capacity;
+        np = np->next;
+    } while (np != lp->head);
+    for (np = lp->spares; np != NULL; np = np->next)
+        slots += np->capacity;
+    return slots;
+}
+
+void testConcatSplitRotate() {
+    LIST* a = createList();
+    LIST* b = createList();
+    int items[600];
+
+    for (int i = 0; i < 600; i++) {
+        items[i] = i;
+        addLast(i < 250 ? a : b, &items[i]);
+    }
+
+    listConcat(a, b);
+    assert(numItems(a) == 600 && numItems(b) == 0);
+    for (int i = 0; i < 600; i++)
+        assert(*(int*) getItem(a, i) == i);
+    addLast(b, &items[0]);
+    assert(*(int*) getFirst(b) == 0);
+    removeFirst(b);
+
+    // Split inside a node, then put the halves back together
+    LIST* c = listSplitAt(a, 333);
+    assert(numItems(a) == 333 && numItems(c) == 267);
+    assert(*(int*) getLast(a) == 332 && *(int*) getFirst(c) == 333);
+    listConcat(b, c);
+    listConcat(b, a);
+    assert(numItems(b) == 600);
+    for (int i = 0; i < 600; i++)
+        assert(*(int*) getItem(b, i) == (i + 333) % 600);
+
+    listRotate(b, 267);
+    for (int i = 0; i < 600; i++)
+        assert(*(int*) getItem(b, i) == i);
+    listRotate(b, -5);
+    assert(*(int*) getFirst(b) == 595 && *(int*) getLast(b) == 594);
+
+    // Splitting off everything moves the nodes' slots but leaves the spares' with the list
+    listSetTrimPolicy(b, LIST_TRIM_SPARE, 4);
+    for (int i = 0; i < 200; i++)
+        removeFirst(b);
+    assert(b->numSpares > 0);
+    LIST* d = listSplitAt(b, 0);
+    assert(numItems(b) == 0 && numItems(d) == 400);
+    assert(b->slots == heldSlots(b) && d->slots == heldSlots(d));
+
+    destroyList(a);
+    destroyList(b);
+    destroyList(c);
+    destroyList(d);
+}
+
+typedef struct {
+    short x, y;
+    char tag;
+} POINT;
+
+void testValueList() {
+    LIST* list = createListOfSize(sizeof(POINT));
+    POINT p;
+    POINT batch[50];
+
+    for (int i = 0; i < 200; i++) {
+        p.x = i;
+        p.y = -i;
+        p.tag = 'a' + i % 26;
+        if (i % 2 == 0)
+            addLastValue(list, &p);
+        else
+            addFirstValue(list, &p);
+    }
+    assert(numItems(list) == 200);
+    assert(((POINT*) getFirstRef(list))->x == 199);
+    assert(((POINT*) getLastRef(list))->x == 198);
+    assert(((POINT*) getItemRef(list, 100))->x == 0);
+
+    removeFirstValue(list, &p);
+    assert(p.x == 199 && p.y == -199 && p.tag == 'a' + 199 % 26);
+    removeLastValue(list, NULL);
+    removeLastN(list, batch, 50);
+    for (int i = 0; i < 50; i++)
+        assert(batch[i].x == 2 * (i + 49));
+    addFirstN(list, batch, 50);
+    assert(((POINT*) getFirstRef(list))->x == 98);
+
+    LIST* other = listSplitAt(list, 10);
+    listConcat(other, list);
+    assert(numItems(other) == 198 && numItems(list) == 0);
+
+    destroyList(list);
+    destroyList(other);
+}
+
+void testTypedList() {
+    LIST_int* list = createList_int();
+
+    for (int i = 0; i < 500; i++) {
+        addLast_int(list, i);
+        addFirst_int(list, -i);
+    }
+    assert(numItems_int(list) == 1000);
+    assert(getFirst_int(list) == -499 && getLast_int(list) == 499);
+    assert(getItem_int(list, 500) == 0);
+    setItem_int(list, 500, 42);
+    assert(*(int*) getItemRef(asList_int(list), 500) == 42);
+
+    for (int i = 499; i > 0; i--) {
+        assert(removeFirst_int(list) == -i);
+        assert(removeLast_int(list) == i);
+    }
+    assert(removeLast_int(list) == 42 && removeLast_int(list) == 0);
+    assert(numItems_int(list) == 0);
+    assert(asList_int(list)->numNodes == 1);
+
+    destroyList_int(list);
+}
+
+int compareInts(const void* a, const void* b) {
+    return (*(int*) a > *(int*) b) - (*(int*) a < *(int*) b);
+}
+
+void testSort() {
+    int sizes[4] = {0, 1, 17, 5000};
+
+    for (int t = 0; t < 4; t++) {
+        for (int pattern = 0; pattern < 4; pattern++) {
+            LIST* list = createListOfSize(sizeof(int));
+            for (int i = 0; i < sizes[t]; i++) {
+                int x = pattern == 0 ? rand() % 1000 : pattern == 1 ? i : pattern == 2 ? -i : 7;
+                if (i % 3 == 0)
+                    addFirstValue(list, &x);
+                else
+                    addLastValue(list, &x);
+            }
+            listSort(list, compareInts);
+            assert(numItems(list) == sizes[t]);
+            for (int i = 1; i < numItems(list); i++)
+                assert(*(int*) getItemRef(list, i - 1) <= *(int*) getItemRef(list, i));
+            destroyList(list);
+        }
+    }
+
+    // Exercise the heapsort fallback directly
+    LIST* list = createListOfSize(sizeof(int));
+    for (int i = 0; i < 300; i++) {
+        int x = (i * 7919) % 300;
+        addLastValue(list, &x);
+    }
+    char tmp[sizeof(int)];
+    heapSortRange(list, 10, 289, compareInts, tmp);
+    for (int i = 11; i < 290; i++)
+        assert(*(int*) getItemRef(list, i - 1) <= *(int*) getItemRef(list, i));
+    destroyList(list);
+}
+
+uint64_t intKey(const void* p) {
+    return (uint32_t) *(int*) p ^ 0x80000000u;
+}
+
+typedef struct {
+    uint64_t key;
+    int seq;
+} RECORD;
+
+uint64_t recordKey(const void* p) {
+    return ((RECORD*) p)->key;
+}
+
+void testRadixSort() {
+    // Signed ints, with the sign bit flipped so negatives sort first
+    LIST* list = createListOfSize(sizeof(int));
+    for (int i = 0; i < 5000; i++) {
+        int x = rand() % 2001 - 1000;
+        if (i % 3 == 0)
+            addFirstValue(list, &x);
+        else
+            addLastValue(list, &x);
+    }
+    listRadixSort(list, intKey);
+    assert(numItems(list) == 5000);
+    for (int i = 1; i < numItems(list); i++)
+        assert(*(int*) getItemRef(list, i - 1) <= *(int*) getItemRef(list, i));
+    destroyList(list);
+
+    // Wide keys with few distinct values; equal keys must keep their order
+    list = createListOfSize(sizeof(RECORD));
+    for (int i = 0; i < 3000; i++) {
+        RECORD r = {(uint64_t) (rand() % 10) << 40 | 0xff, i};
+        addLastValue(list, &r);
+    }
+    listRadixSort(list, recordKey);
+    for (int i = 1; i < numItems(list); i++) {
+        RECORD* a = getItemRef(list, i - 1);
+        RECORD* b = getItemRef(list, i);
+        assert(a->key < b->key || (a->key == b->key && a->seq < b->seq));
+    }
+    destroyList(list);
+}
+
+void testParallelSort() {
+    int sizes[3] = {100, 20000, 100000};
+    int threads[3] = {2, 3, 8};
+
+    for (int t = 0; t < 3; t++) {
+        for (int pattern = 0; pattern < 3; pattern++) {
+            LIST* list = createListOfSize(sizeof(int));
+            long sum = 0;
+            for (int i = 0; i < sizes[t]; i++) {
+                int x = pattern == 0 ? rand() - RAND_MAX / 2 : pattern == 1 ? sizes[t] - i : rand() % 4;
+                sum += x;
+                if (i % 3 == 0)
+                    addFirstValue(list, &x);
+                else
+                    addLastValue(list, &x);
+            }
+            LIST* copy = createListOfSize(sizeof(int));
+            for (int i = 0; i < sizes[t]; i++)
+                addLastValue(copy, getItemRef(list, i));
+
+            listParallelSort(list, compareInts, threads[t]);
+            listParallelRadixSort(copy, intKey, threads[t]);
+            assert(numItems(list) == sizes[t] && numItems(copy) == sizes[t]);
+            for (int i = 0; i < sizes[t]; i++) {
+                sum -= *(int*) getItemRef(list, i);
+                assert(*(int*) getItemRef(list, i) == *(int*) getItemRef(copy, i));
+                if (i > 0)
+                    assert(*(int*) getItemRef(list, i - 1) <= *(int*) getItemRef(list, i));
+            }
+            assert(sum == 0);
+            destroyList(list);
+            destroyList(copy);
+        }
+    }
+}
+
+void testAddRemoveAt() {
+    // Sorted insertion against a plain array as the reference
+    int n = 20000;
+    int* ref = malloc(n * sizeof(int));
+    LIST* list = createListOfSize(sizeof(int));
+    for (int i = 0; i < n; i++) {
+        int x = rand() % 100000, lo = 0, hi = i;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (ref[mid] < x)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        memmove(ref + lo + 1, ref + lo, (i - lo) * sizeof(int));
+        ref[lo] = x;
+        addAtValue(list, lo, &x);
+    }
+    assert(numItems(list) == n);
+    for (int i = 0; i < n; i++)
+        assert(*(int*) getItemRef(list, i) == ref[i]);
+
+    // Middle nodes stay near the square root of the count
+    for (int p = 0; p < list->numNodes; p++)
+        assert(list->index[p].np->count <= 512);
+
+    // Remove from random positions until only a few are left, so nodes merge
+    for (int len = n; len > 10; len--) {
+        int at = rand() % len, x;
+        removeAtValue(list, at, &x);
+        assert(x == ref[at]);
+        memmove(ref + at, ref + at + 1, (len - at - 1) * sizeof(int));
+    }
+    for (int i = 0; i < 10; i++)
+        assert(*(int*) getItemRef(list, i) == ref[i]);
+    assert(list->numNodes <= 2);
+    destroyList(list);
+    free(ref);
+
+    // Pointer and typed versions, including the ends and a list built at one end
+    list = createList();
+    int items[4] = {1, 2, 3, 4};
+    addAt(list, 0, &items[1]);
+    addAt(list, 0, &items[0]);
+    addAt(list, 2, &items[3]);
+    addAt(list, 2, &items[2]);
+    for (int i = 0; i < 4; i++)
+        assert(getItem(list, i) == &items[i]);
+    assert(removeAt(list, 2) == &items[2] && removeAt(list, 0) == &items[0]);
+    assert(removeAt(list, 1) == &items[3] && removeAt(list, 0) == &items[1]);
+    assert(numItems(list) == 0);
+    destroyList(list);
+
+    LIST_int* typed = createList_int();
+    for (int i = 0; i < 5000; i++)
+        addLast_int(typed, i);
+    addAt_int(typed, 2500, -1);
+    assert(getItem_int(typed, 2499) == 2499 && getItem_int(typed, 2500) == -1 && getItem_int(typed, 2501) == 2500);
+    assert(removeAt_int(typed, 2500) == -1 && removeAt_int(typed, 4000) == 4000);
+    for (int i = 0; i < 4999; i++)
+        assert(getItem_int(typed, i) == (i < 4000 ? i : i + 1));
+    destroyList_int(typed);
+}
+
+void* produceInts(void* arg) {
+    QUEUE* queue = arg;
+    int batch[100];
+    for (int i = 0; i < 1000000;) {
+        if (i % 3 == 0) {
+            queuePush(queue, &i);
+            i++;
+        } else {
+            for (int j = 0; j < 100; j++)
+                batch[j] = i + j;
+            queuePushN(queue, batch, 100);
+            i += 100;
+        }
+    }
+    queueClose(queue);
+    return NULL;
+}
+
+void testQueue() {
+    // One thread, across several nodes
+    QUEUE* queue = createQueue(sizeof(int));
+    int x, out[3000];
+    assert(!queuePop(queue, &x) && !queueFinished(queue));
+    for (int i = 0; i < 2500; i++)
+        queuePush(queue, &i);
+    assert(queuePop(queue, &x) && x == 0);
+    assert(queuePopN(queue, out, 3000) == 2499);
+    for (int i = 0; i < 2499; i++)
+        assert(out[i] == i + 1);
+    queueClose(queue);
+    assert(queueFinished(queue));
+    destroyQueue(queue);
+
+    // A producer thread and this thread as the consumer
+    queue = createQueue(sizeof(int));
+    pthread_t producer;
+    pthread_create(&producer, NULL, produceInts, queue);
+    int expected = 0;
+    while (true) {
+        int n = queuePopN(queue, out, 37);
+        for (int i = 0; i < n; i++)
+            assert(out[i] == expected++);
+        if (n == 0 && queuePop(queue, &x))
+            assert(x == expected++);
+        else if (n == 0 && queueFinished(queue))
+            break;
+    }
+    assert(expected >= 1000000);
+    pthread_join(producer, NULL);
+    destroyQueue(queue);
+}
+
+#define STEAL_ITEMS 200000
+
+DEQUE* stealFrom;
+unsigned char stolen[STEAL_ITEMS];
+atomic_bool ownerDone;
+
+void* stealInts(void* arg) {
+    int x;
+    while (!atomic_load(&ownerDone) || dequeSize(stealFrom) > 0)
+        if (dequeSteal(stealFrom, &x))
+            stolen[x]++;
+    return NULL;
+}
+
+void testDeque() {
+    // One thread: the owner's end is LIFO, the thieves' end FIFO, across ring growth
+    DEQUE* deque = createDeque(sizeof(int));
+    int x;
+    assert(!dequePop(deque, &x) && !dequeSteal(deque, &x));
+    for (int i = 0; i < 1000; i++)
+        dequePush(deque, &i);
+    assert(dequeSize(deque) == 1000);
+    assert(dequePop(deque, &x) && x == 999);
+    assert(dequeSteal(deque, &x) && x == 0);
+    for (int i = 998; i >= 500; i--)
+        assert(dequePop(deque, &x) && x == i);
+    for (int i = 1; i < 500; i++)
+        assert(dequeSteal(deque, &x) && x == i);
+    assert(!dequePop(deque, &x) && dequeSize(deque) == 0);
+    destroyDeque(deque);
+
+    // The owner pushes and pops while three thieves steal; every item goes exactly once
+    stealFrom = createDeque(sizeof(int));
+    static unsigned char popped[STEAL_ITEMS];
+    pthread_t thieves[3];
+    for (int t = 0; t < 3; t++)
+        pthread_create(&thieves[t], NULL, stealInts, NULL);
+    for (int i = 0; i < STEAL_ITEMS; i++) {
+        dequePush(stealFrom, &i);
+        if (i % 3 == 0 && dequePop(stealFrom, &x))
+            popped[x]++;
+    }
+    while (dequePop(stealFrom, &x))
+        popped[x]++;
+    atomic_store(&ownerDone, true);
+    for (int t = 0; t < 3; t++)
+        pthread_join(thieves[t], NULL);
+    for (int i = 0; i < STEAL_ITEMS; i++)
+        assert(popped[i] + stolen[i] == 1);
+    destroyDeque(stealFrom);
+}
+
+void testStats() {
+    LIST* list = createListOfSize(sizeof(int));
+    for (int i = 0; i < 1000; i++)
+        addLastValue(list, &i);
+    for (int i = 0; i < 1000; i += 10)
+        getItemRef(list, i);
+
+    LIST_STATISTICS stats;
+    listGetStats(list, &stats);
+    assert(stats.numNodes == list->numNodes && stats.numSpares == list->numSpares);
+    assert(stats.bytesUsed == 1000 * sizeof(int));
+    assert(stats.bytesReserved >= stats.bytesUsed + list->numNodes * sizeof(NODE));
+
+#ifdef LIST_STATS
+    long pushes = 0, walks = 0;
+    for (int i = 0; i < LIST_STATS_BUCKETS; i++) {
+        pushes += stats.pushes[i];
+        walks += stats.walks[i];
+    }
+    assert(stats.counted && pushes == 1000 && walks >= 100);
+    assert(stats.nodeAllocs == list->numNodes && stats.nodeFrees == 0);
+#else
+    assert(!stats.counted && stats.nodeAllocs == 0 && stats.walks[0] == 0);
+#endif
+
+    FILE* fp = fopen("/dev/null", "w");
+    listDumpStats(list, fp);
+    fclose(fp);
+    destroyList(list);
+}
+
+void testGrowth() {
+    LIST* list = createListOfSize(sizeof(int));
+    listSetGrowth(list, 16, 4, 256);
+    assert(list->head->capacity == 16);
+    for (int i = 0; i < 10000; i++)
+        addLastValue(list, &i);
+    for (int i = -1; i >= -10000; i--)
+        addFirstValue(list, &i);
+    int bulk[5000];
+    for (int i = 0; i < 5000; i++)
+        bulk[i] = 10000 + i;
+    addLastN(list, bulk, 5000);
+    addFirstN(list, bulk, 5000);
+    for (int i = 0; i < 1000; i++)
+        addAtValue(list, 7000 + i * 5, &i);
+    for (int i = 0; i < list->numNodes; i++)
+        assert(list->index[i].np->capacity <= 256 / sizeof(int));
+    assert(*(int*) getItemRef(list, 0) == 10000 && *(int*) getItemRef(list, 5000) == -10000);
+    assert(*(int*) getItemRef(list, numItems(list) - 1) == 14999);
+
+    LIST* rest = listSplitAt(list, 100);
+    assert(rest->maxCapacity == list->maxCapacity && rest->growthFactor == 4);
+    destroyList(rest);
+    destroyList(list);
+
+    list = createList();
+    listSetGrowth(list, 2, 2, 0);
+    for (long i = 1; i <= 100000; i++)
+        addLast(list, (void*) i);
+    assert(list->head->prev->capacity >= 65536);
+    destroyList(list);
+}
+
+void testReserve() {
+    LIST* list = createListWithCapacity(100000);
+    long slots = list->slots;
+    ENTRY* entries = list->entries;
+    for (long i = 1; i <= 100000; i++)
+        addLast(list, (void*) i);
+    assert(list->slots == slots && list->entries == entries);
+    assert(getItem(list, 99999) == (void*) 100000L);
+    destroyList(list);
+
+    list = createList();
+    addLast(list, (void*) 1L);
+    listReserve(list, 50000);
+    listReserve(list, 50000);
+    slots = list->slots;
+    entries = list->entries;
+    for (long i = 0; i < 50000; i++)
+        addFirst(list, (void*) 2L);
+    assert(list->slots == slots && list->entries == entries && numItems(list) == 50001);
+    assert(getLast(list) == (void*) 1L);
+    destroyList(list);
+
+    LIST_int* ints = createListWithCapacity_int(1000);
+    slots = asList_int(ints)->slots;
+    for (int i = 0; i < 1000; i++)
+        addLast_int(ints, i);
+    assert(asList_int(ints)->slots == slots && getItem_int(ints, 999) == 999);
+    destroyList_int(ints);
+}
+
+uint64_t longKey(const void* p) {
+    return *(const long*) p;
+}
+
+void testMappedList() {
+    LIST* list = createMappedListOfSize(sizeof(long));
+    for (long i = 0; i < 2000000; i++)
+        addLastValue(list, &i);
+    assert(list->maxCapacity == LIST_HUGE_NODE_BYTES / sizeof(long));
+    NODE* last = list->head->prev;
+    assert(last->capacity * sizeof(long) >= LIST_HUGE_PAGE_SIZE);
+    assert((uintptr_t) last % LIST_HUGE_PAGE_SIZE == 0);
+
+    long x;
+    for (long i = 0; i < 1500000; i++) {
+        removeFirstValue(list, &x);
+        assert(x == i);
+    }
+    for (long i = 0; i < 1500000; i++)
+        addFirstValue(list, &i);
+    listAdvise(list, LIST_ADVISE_SEQUENTIAL);
+    listRadixSort(list, longKey);
+    listParallelRadixSort(list, longKey, 4);
+    for (int i = 0; i < numItems(list); i += 1000)
+        assert(*(long*) getItemRef(list, i) == i);
+    listAdvise(list, LIST_ADVISE_NORMAL);
+    destroyList(list);
+
+    // Spare pages are dropped on the mapping's own page boundaries, huge pages included
+    size_t sizes[] = {MAP_THRESHOLD, MAP_HUGETLB_MIN, LIST_HUGE_NODE_BYTES + 4096};
+    for (int i = 0; i < 3; i++) {
+        NODE* np = listMapAlloc(NULL, sizes[i]);
+        assert(np != NULL && (uintptr_t) np % mapPageSize(sizes[i]) == 0);
+        memset(np, 1, sizes[i]);
+        assert(discardPages(np, sizes[i]));
+        assert(*(char*) np == 1 && ((char*) np)[sizes[i] - 1] == 0);
+        listMapFree(NULL, np, sizes[i]);
+    }
+    NODE* small = listMapAlloc(NULL, 4096);
+    assert(!discardPages(small, 4096));
+    listMapFree(NULL, small, 4096);
+}
+
+void testSnapshot() {
+    char path[] = "/tmp/listsnapXXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    LIST* list = createListOfSize(sizeof(int));
+    assert(listSave(list, path));
+    LIST* mapped = listMap(path);
+    assert(mapped != NULL && numItems(mapped) == 0);
+    addLastValue(mapped, &fd);
+    destroyList(mapped);
+
+    for (int i = 0; i < 3000000; i++)
+        addLastValue(list, &i);
+    assert(listSave(list, path));
+    mapped = listMap(path);
+    assert(mapped != NULL && numItems(mapped) == 3000000 && mapped->numNodes == 2);
+    for (int i = 0; i < 3000000; i += 997)
+        assert(*(int*) getItemRef(mapped, i) == i);
+
+    int x = -1;
+    addFirstValue(mapped, &x);
+    addAtValue(mapped, 1000, &x);
+    removeAtValue(mapped, 1000, &x);
+    *(int*) getItemRef(mapped, 5) = -5;
+    listRadixSort(mapped, intKey);
+    assert(*(int*) getItemRef(mapped, 0) == -5 && *(int*) getItemRef(mapped, 1) == -1);
+    assert(*(int*) getItemRef(mapped, 2) == 0 && *(int*) getItemRef(mapped, 6) == 5);
+
+    LIST* again = listMap(path);
+    assert(again != NULL && *(int*) getItemRef(again, 5) == 5 && numItems(again) == 3000000);
+    LIST* rest = listSplitAt(again, 2000000);
+    destroyList(again);
+    assert(*(int*) getItemRef(rest, 0) == 2000000);
+    destroyList(rest);
+    destroyList(mapped);
+    destroyList(list);
+
+    // A node whose capacity is not a power of two would be indexed through the wrong mask
+    list = createListOfSize(sizeof(int));
+    for (int i = 0; i < 5; i++)
+        addLastValue(list, &i);
+    assert(listSave(list, path));
+    destroyList(list);
+    unsigned capacity = 6, mask = 5;
+    fd = open(path, O_WRONLY);
+    assert(pwrite(fd, &capacity, sizeof(capacity), SNAPSHOT_ALIGNMENT + offsetof(NODE, capacity)) == sizeof(capacity));
+    assert(pwrite(fd, &mask, sizeof(mask), SNAPSHOT_ALIGNMENT + offsetof(NODE, mask)) == sizeof(mask));
+    close(fd);
+    assert(listMap(path) == NULL);
+
+    FILE* fp = fopen(path, "w");
+    fputs("not a snapshot\n", fp);
+    fclose(fp);
+    assert(listMap(path) == NULL);
+    unlink(path);
+    assert(listMap(path) == NULL);
+}
+
+void testArena() {
+    ARENA* arena = createArena(64);
+    char* first = arenaCopy(arena, "hello", 5);
+    char* second = arenaCopy(arena, "world!", 6);
+    assert(strcmp(first, "hello") == 0 && strcmp(second, "world!") == 0);
+    assert(second == first + 6 && arenaSize(arena) == 13);
+
+    long* numbers = arenaAlloc(arena, 10 * sizeof(long));
+    assert((uintptr_t) numbers % 16 == 0);
+    for (int i = 0; i < 10; i++)
+        numbers[i] = i;
+
+    char big[1000];
+    memset(big, 'x', sizeof(big));
+    char* copy = arenaCopy(arena, big, sizeof(big));
+    assert(copy[999] == 'x' && copy[1000] == '\0');
+    char* words[10000];
+    for (int i = 0; i < 10000; i++) {
+        char buf[16];
+        int n = sprintf(buf, "w%d", i);
+        words[i] = arenaCopy(arena, buf, n);
+    }
+    for (int i = 0; i < 10000; i += 97) {
+        char buf[16];
+        sprintf(buf, "w%d", i);
+        assert(strcmp(words[i], buf) == 0);
+    }
+    assert(numbers[9] == 9 && strcmp(first, "hello") == 0);
+    assert(arenaCopy(arena, "", 0)[0] == '\0');
+    destroyArena(arena);
+}
+
+void testFastIO() {
+    char path[] = "/tmp/fastioXXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    const char* text = "  7 42\n\t123456789 2147483647\r\n0 00012 99999999 -5 8";
+    assert(write(fd, text, strlen(text)) == (ssize_t) strlen(text));
+    close(fd);
+
+    int ints[16];
+    INPUT* in = openInput(path);
+    assert(in != NULL);
+    assert(scanInts(in, ints, 2) == 2 && ints[0] == 7 && ints[1] == 42);
+    assert(scanInts(in, ints, 16) == 5 && ints[0] == 123456789 && ints[1] == 2147483647);
+    assert(ints[2] == 0 && ints[3] == 12 && ints[4] == 99999999);
+    assert(peekInput(in) == '-');
+    closeInput(in);
+
+    // Numbers too large for an int, however long, and trailing garbage stop the scan unread
+    const char* bad[] = {"3 2147483648 1", "3 18446744073709551617 1", "3 100000000000000000000000 1", "3 1 abc"};
+    for (int i = 0; i < 4; i++) {
+        fd = open(path, O_WRONLY | O_TRUNC);
+        assert(write(fd, bad[i], strlen(bad[i])) == (ssize_t) strlen(bad[i]));
+        close(fd);
+        in = openInput(path);
+        int n = scanInts(in, ints, 16);
+        assert(ints[0] == 3 && (i < 3 ? n == 1 && peekInput(in) == bad[i][2] : n == 2 && peekInput(in) == 'a'));
+        closeInput(in);
+    }
+    fd = open(path, O_WRONLY | O_TRUNC);
+    assert(write(fd, text, strlen(text)) == (ssize_t) strlen(text));
+    close(fd);
+
+    LIST* list = createListOfSize(sizeof(WORD));
+    ARENA* arena = createArena(0);
+    in = openInput(path);
+    assert(loadWords(in, list, arena, true) == 9 && peekInput(in) == -1);
+    closeInput(in);
+    assert(strcmp(((WORD*) getItemRef(list, 0))->text, "7") == 0);
+    assert(strcmp(((WORD*) getItemRef(list, 7))->text, "-5") == 0);
+    assert(strcmp(((WORD*) getLastRef(list))->text, "8") == 0);
+    destroyList(list);
+    LIST* values = createListOfSize(sizeof(int));
+    fd = open(path, O_WRONLY | O_TRUNC);
+    OUTPUT* out = openOutput(fd);
+    for (int i = 0; i < 300000; i++) {
+        putUnsigned(out, i * 7001u);
+        putChar(out, '\n');
+    }
+    char word[3000];
+    memset(word, 'w', sizeof(word));
+    for (int i = 0; i < 1000; i++)
+        putBytes(out, word, sizeof(word));
+    putChar(out, '\n');
+    assert(closeOutput(out));
+    close(fd);
+
+    in = openInput(path);
+    assert(loadInts(in, values, false) == 300000);
+    for (int i = 0; i < 300000; i += 777)
+        assert(*(int*) getItemRef(values, i) == (int) (i * 7001u));
+    const char* words[2];
+    size_t lengths[2];
+    assert(scanWords(in, words, lengths, 2) == 1 && lengths[0] == 3000000);
+    closeInput(in);
+
+    text = "abcdefgh abcdefghi abcdefgh abc ab abd abcdefgha abcdefgh\xff \xc3\xa9t\xc3\xa9 zz";
+    fd = open(path, O_WRONLY | O_TRUNC);
+    assert(write(fd, text, strlen(text)) == (ssize_t) strlen(text));
+    close(fd);
+    list = createListOfSize(sizeof(WORD));
+    in = openInput(path);
+    assert(loadWords(in, list, arena, false) == 10);
+    closeInput(in);
+    for (int i = 0; i < 10; i++)
+        for (int j = 0; j < 10; j++) {
+            WORD* a = getItemRef(list, i);
+            WORD* b = getItemRef(list, j);
+            int expected = strcmp(a->text, b->text);
+            int actual = compareWords(a, b);
+            assert((expected < 0) == (actual < 0) && (expected > 0) == (actual > 0));
+        }
+
+    unlink(path);
+    destroyList(values);
+    destroyList(list);
+    destroyArena(arena);
+}
+
+bool isMultipleOfSeven(const void* p) {
+    return *(int*) p > 0 && *(int*) p % 7 == 0;
+}
+
+void testSearch() {
+    // Every kernel must agree with the scalar one for every length and match position
+    void* items[40];
+    void* key = &items[0];
+    for (unsigned n = 0; n <= 40; n++)
+        for (unsigned m = 0; m <= n; m++) {
+            for (unsigned i = 0; i < n; i++)
+                items[i] = (i == m || i + 3 == n) ? key : (void*) (uintptr_t) (i + 1);
+            unsigned first = findFirstScalar(items, n, key);
+            unsigned last = findLastScalar(items, n, key);
+            unsigned count = countScalar(items, n, key);
+            assert(first == (n >= 3 && n - 3 < m ? n - 3 : m));
+#ifdef __x86_64__
+            assert(findFirstSSE2(items, n, key) == first && findLastSSE2(items, n, key) == last);
+            assert(countSSE2(items, n, key) == count);
+            if (__builtin_cpu_supports("avx2")) {
+                assert(findFirstAVX2(items, n, key) == first && findLastAVX2(items, n, key) == last);
+                assert(countAVX2(items, n, key) == count);
+            }
+#endif
+        }
+
+    // Items added at both ends and removed from the front leave rings that wrap around
+    LIST* list = createList();
+    int values[100];
+    assert(listIndexOf(list, &values[0]) == -1 && listLastIndexOf(list, &values[0]) == -1);
+    assert(listCount(list, &values[0]) == 0);
+    for (int i = 0; i < 5000; i++) {
+        if (i % 3 == 0)
+            addFirst(list, &values[i % 100]);
+        else
+            addLast(list, &values[i % 100]);
+    }
+    for (int i = 0; i < 777; i++)
+        removeFirst(list);
+    addLast(list, &values[99]);
+    for (int v = 0; v < 100; v += 9) {
+        int first = -1, last = -1, count = 0;
+        for (int i = 0; i < numItems(list); i++)
+            if (getItem(list, i) == &values[v]) {
+                if (first < 0)
+                    first = i;
+                last = i;
+                count++;
+            }
+        assert(listIndexOf(list, &values[v]) == first && listLastIndexOf(list, &values[v]) == last);
+        assert(listCount(list, &values[v]) == count);
+    }
+    assert(listLastIndexOf(list, &values[99]) == numItems(list) - 1);
+    assert(listIndexOf(list, &list) == -1 && listCount(list, &list) == 0);
+    destroyList(list);
+
+    list = createListOfSize(sizeof(int));
+    assert(listFindIf(list, isMultipleOfSeven) == -1);
+    for (int i = 1; i <= 20; i++)
+        addFirstValue(list, &i);
+    assert(listFindIf(list, isMultipleOfSeven) == 6);
+    for (int i = 0; i < 10; i++)
+        removeFirstValue(list, NULL);
+    assert(listFindIf(list, isMultipleOfSeven) == 3);
+    destroyList(list);
+}
+
+_Atomic long eachSum;
+
+void addToSum(const void* p) {
+    eachSum += *(int*) p;
+}
+
+void tripleInt(void* p) {
+    *(int*) p *= 3;
+}
+
+bool outsideMiddle(const void* p) {
+    int x = *(int*) p;
+    return x % 2 == 0 && (x < 30000 || x >= 150000);
+}
+
+bool keepNone(const void* p) {
+    return false;
+}
+
+void testEach() {
+    LIST_WORKERS* workers = createListWorkers(4);
+    for (int parallel = 0; parallel < 2; parallel++) {
+        LIST_WORKERS* wp = parallel ? workers : NULL;
+        LIST* list = createListOfSize(sizeof(int));
+        for (int i = 0; i < 100000; i++)
+            addLastValue(list, &i);
+        for (int i = -1; i >= -100000; i--)
+            addFirstValue(list, &i);
+        for (int i = 0; i < 1000; i++)
+            removeFirstValue(list, NULL);
+
+        eachSum = 0;
+        listParallelForEach(list, addToSum, wp);
+        assert(eachSum == -99000L * 99001 / 2 + 99999L * 100000 / 2);
+        listParallelMapInPlace(list, tripleInt, wp);
+        assert(*(int*) getFirstRef(list) == -99000 * 3 && *(int*) getLastRef(list) == 99999 * 3);
+
+        // Keeps the even multiples of three outside [30000, 150000), emptying whole nodes
+        int removed = listParallelFilterInPlace(list, outsideMiddle, wp);
+        int expected = 0;
+        for (int i = -99000; i < 100000; i++)
+            if (outsideMiddle(&(int) {i * 3}))
+                expected++;
+        assert(numItems(list) == expected && removed == 199000 - expected);
+        int prev = INT_MIN, n = 0;
+        LIST_CURSOR c;
+        listCursorSeek(&c, list, 0);
+        do {
+            int x = *(int*) listCursorRef(&c);
+            assert(x > prev && outsideMiddle(&x) && x % 3 == 0);
+            assert(*(int*) getItemRef(list, n++) == x);
+            prev = x;
+        } while (listCursorNext(&c));
+        assert(n == expected);
+
+        int x = 7;
+        addAtValue(list, expected / 2, &x);
+        assert(*(int*) getItemRef(list, expected / 2) == 7);
+        removeAtValue(list, expected / 2, NULL);
+        assert(listParallelFilterInPlace(list, keepNone, wp) == expected && numItems(list) == 0);
+        addLastValue(list, &x);
+        addFirstValue(list, &x);
+        assert(numItems(list) == 2 && *(int*) getItemRef(list, 1) == 7);
+        destroyList(list);
+    }
+
+    LIST* list = createListOfSize(sizeof(int));
+    for (int i = 0; i < 10; i++)
+        addLastValue(list, &i);
+    eachSum = 0;
+    listForEach(list, addToSum);
+    listMapInPlace(list, tripleInt);
+    assert(eachSum == 45 && *(int*) getItemRef(list, 9) == 27);
+    assert(listFilterInPlace(list, outsideMiddle) == 5 && *(int*) getItemRef(list, 4) == 24);
+    destroyList(list);
+    destroyListWorkers(workers);
+}
+
 int main() {
     testCreateDestroyList();
     printf(":yes:\n");
@@ -92,6 +1129,29 @@ int main() {
     testRemoveFirstLast();
     testGetFirstLastItem();
     testGetSetItem();
+    testGetSetItemManyNodes();
+    testTrimPolicies();
+    testPoolAllocator();
+    testCursor();
+    testBulk();
+    testConcatSplitRotate();
+    testValueList();
+    testTypedList();
+    testSort();
+    testRadixSort();
+    testParallelSort();
+    testAddRemoveAt();
+    testQueue();
+    testDeque();
+    testStats();
+    testGrowth();
+    testReserve();
+    testMappedList();
+    testSnapshot();
+    testArena();
+    testFastIO();
+    testSearch();
+    testEach();
 
     printf("All tests passed successfully.\n");
     return 0;
@@ -15,6 +15,12 @@
  *		the maze and the rear of the list as the top when solving
  *		the maze.
  *
+ *		With the -t option, the program instead runs headless: it
+ *		generates a maze of the size given by -w and -h and solves
+ *		it with the given number of threads, each running a
+ *		depth-first search from its own work-stealing deque and
+ *		stealing cells from the others when it runs dry.
+ *
  *		Most of the ideas in this code are taken from either
  *		Wikipedia (see comments below) or from the following URL:
  *
@@ -24,50 +30,63 @@
 # include <time.h>		/* for time(), used to seed the rng */
 # include <stdio.h>
 # include <stdlib.h>
+# include <stdint.h>
+# include <limits.h>
 # include <assert.h>
 # include <curses.h>
 # include <unistd.h>		/* for usleep() */
 # include <stdbool.h>
+# include <stdatomic.h>
+# include <pthread.h>
 # include "list.h"
+# include "listtype.h"
+# include "deque.h"
 
 # define delay 20000
+# define DEFAULT_SIZE 1000		/* headless width and height */
 
 typedef struct cell CELL;
 typedef struct coord COORD;
 
+struct coord {
+    short x, y;
+};
+
+DEFINE_LIST(coord, COORD)
+
 int width;
 int height;
-LIST *list;
+LIST_coord *list;
+LIST_POOL *pool;
 CELL **maze;
 
+int numWorkers;
+DEQUE **deques;
+atomic_bool *claimed;
+atomic_bool solved;
+
 struct cell {
     int from;
     bool bottom, right, visited;
 };
 
-struct coord {
-    short x, y;
-};
-
 
 /*
  * Function:	mkcoord
  *
- * Description:	Allocate and initialize a new coordinate pair.
+ * Description:	Make a coordinate pair.  The list stores coordinates by
+ *		value, so no memory needs to be allocated.
  */
 
-static COORD *mkcoord(int x, int y)
+static COORD mkcoord(int x, int y)
 {
-    COORD *cp;
+    COORD c;
 
 
-    cp = malloc(sizeof(COORD));
-    assert(cp != NULL);
+    c.x = x;
+    c.y = y;
 
-    cp->x = x;
-    cp->y = y;
-
-    return cp;
+    return c;
 }
 
 
@@ -165,13 +184,15 @@ static void initMaze(void)
  * Description:	Build the maze using depth-first search.  The algorithm is
  *		taken directly from wikipedia.org/wiki/Maze_generation.  In
  *		this function and in subsequent functions, the current cell
- *		is represented by a two-dimensional coordinate.
+ *		is represented by a two-dimensional coordinate.  The list
+ *		is the only stack used, so even a huge maze cannot overflow
+ *		the call stack.
  */
 
 static void buildMaze(int y, int x)
 {
     int numOffsets, offset, offsets[4];
-    COORD *cp;
+    COORD c;
 
 
     while (1) {
@@ -192,28 +213,27 @@ static void buildMaze(int y, int x)
 
 	if (numOffsets > 0) {
 	    offset = offsets[rand() % numOffsets];
-	    addFirst(list, mkcoord(x, y));
+	    addFirst_coord(list, mkcoord(x, y));
 
 	    if (offset == -width) {
 		maze[y - 1][x].bottom = false;
-		buildMaze(y - 1, x);
+		y --;
 	    } else if (offset == width) {
 		maze[y][x].bottom = false;
-		buildMaze(y + 1, x);
+		y ++;
 	    } else if (offset == -1) {
 		maze[y][x - 1].right = false;
-		buildMaze(y, x - 1);
+		x --;
 	    } else if (offset == 1) {
 		maze[y][x].right = false;
-		buildMaze(y, x + 1);
+		x ++;
 	    } else
 		abort();
 
-	} else if (numItems(list) > 0) {
-	    cp = removeFirst(list);
-	    x = cp->x;
-	    y = cp->y;
-	    free(cp);
+	} else if (numItems_coord(list) > 0) {
+	    c = removeFirst_coord(list);
+	    x = c.x;
+	    y = c.y;
 
 	} else
 	    break;
@@ -333,7 +353,7 @@ static void printMaze(void)
 static void solveMaze(void)
 {
     int x, y;
-    COORD *cp;
+    COORD c;
 
 
     for (y = 0; y < height; y ++)
@@ -348,83 +368,283 @@ static void solveMaze(void)
 	maze[y][x].visited = true;
 
 	if (!maze[y][x].right && !maze[y][x + 1].visited) {
-	    addLast(list, mkcoord(x + 1, y));
+	    addLast_coord(list, mkcoord(x + 1, y));
 	    maze[y][x + 1].from = 1;
 	}
 
 	if (!maze[y][x].bottom && !maze[y + 1][x].visited) {
-	    addLast(list, mkcoord(x, y + 1));
+	    addLast_coord(list, mkcoord(x, y + 1));
 	    maze[y + 1][x].from = width;
 	}
 
 	if (x > 0 && !maze[y][x - 1].right && !maze[y][x - 1].visited) {
-	    addLast(list, mkcoord(x - 1, y));
+	    addLast_coord(list, mkcoord(x - 1, y));
 	    maze[y][x - 1].from = -1;
 	}
 
 	if (y > 0 && !maze[y - 1][x].bottom && !maze[y - 1][x].visited) {
-	    addLast(list, mkcoord(x, y - 1));
+	    addLast_coord(list, mkcoord(x, y - 1));
 	    maze[y - 1][x].from = -width;
 	}
 
-	cp = getItem(list, numItems(list) - 1);
-	/*cp = getLast(list);*/
+	c = getLast_coord(list);
 
-	if (cp->x == x && cp->y == y) {
+	if (c.x == x && c.y == y) {
 	    draw(x, y, false);
-	    removeLast(list);
-	    free(cp);
+	    removeLast_coord(list);
 	}
 
-	cp = getItem(list, numItems(list) - 1);
-	/*cp = getLast(list);*/
-	x = cp->x;
-	y = cp->y;
+	c = getLast_coord(list);
+	x = c.x;
+	y = c.y;
     }
 
     draw(width - 1, height - 1, true);
 }
 
 
+/*
+ * Function:	claim
+ *
+ * Description:	Claim a cell for the calling worker, recording the
+ *		direction whence we came and pushing the cell onto the
+ *		worker's deque.  A cell is claimed at most once, so no two
+ *		workers ever search from the same cell.
+ */
+
+static void claim(DEQUE *dp, int x, int y, int from)
+{
+    if (!atomic_exchange_explicit(&claimed[y * width + x], true, memory_order_relaxed)) {
+	maze[y][x].from = from;
+	dequePush(dp, &(COORD) {x, y});
+    }
+}
+
+
+/*
+ * Function:	searchMaze
+ *
+ * Description:	Run one worker of the parallel solver.  The worker takes
+ *		the most recently claimed cell from the bottom of its own
+ *		deque, so each worker goes depth first, and claims the
+ *		cell's open neighbors in the same order as solveMaze.
+ *		When its deque is empty, it steals the oldest cell from a
+ *		random victim, which is near the root of the victim's part
+ *		of the search and so likely to lead to a lot of work.  The
+ *		first worker to reach the exit stops everyone.
+ */
+
+static void *searchMaze(void *arg)
+{
+    int id, victim, x, y;
+    long explored;
+    unsigned seed;
+    COORD c;
+
+
+    id = (int) (intptr_t) arg;
+    seed = id * 2654435761u + 1;
+    explored = 0;
+
+    while (!atomic_load_explicit(&solved, memory_order_acquire)) {
+	if (!dequePop(deques[id], &c)) {
+	    victim = rand_r(&seed) % numWorkers;
+
+	    if (victim == id || !dequeSteal(deques[victim], &c))
+		continue;
+	}
+
+	x = c.x;
+	y = c.y;
+	explored ++;
+
+	if (y == height - 1 && x == width - 1) {
+	    atomic_store_explicit(&solved, true, memory_order_release);
+	    break;
+	}
+
+	if (!maze[y][x].right)
+	    claim(deques[id], x + 1, y, 1);
+
+	if (!maze[y][x].bottom)
+	    claim(deques[id], x, y + 1, width);
+
+	if (x > 0 && !maze[y][x - 1].right)
+	    claim(deques[id], x - 1, y, -1);
+
+	if (y > 0 && !maze[y - 1][x].bottom)
+	    claim(deques[id], x, y - 1, -width);
+    }
+
+    return (void *) (intptr_t) explored;
+}
+
+
+/*
+ * Function:	solveMazeParallel
+ *
+ * Description:	Solve the maze without drawing it, using the given number
+ *		of threads, and return the number of cells on the path
+ *		from the entrance to the exit.  The path is recovered by
+ *		following the recorded directions back from the exit.
+ */
+
+static int solveMazeParallel(int threads, long *explored)
+{
+    int i, x, y, length;
+    void *count;
+    pthread_t *tids;
+
+
+    numWorkers = threads;
+    deques = malloc(sizeof(DEQUE *) * threads);
+    tids = malloc(sizeof(pthread_t) * threads);
+    claimed = calloc((size_t) width * height, sizeof(atomic_bool));
+    assert(deques != NULL && tids != NULL && claimed != NULL);
+
+    for (i = 0; i < threads; i ++)
+	deques[i] = createDeque(sizeof(COORD));
+
+    atomic_store(&solved, false);
+    atomic_store(&claimed[0], true);
+    maze[0][0].from = 0;
+    dequePush(deques[0], &(COORD) {0, 0});
+
+    for (i = 1; i < threads; i ++)
+	pthread_create(&tids[i], NULL, searchMaze, (void *) (intptr_t) i);
+
+    *explored = (long) (intptr_t) searchMaze((void *) 0);
+
+    for (i = 1; i < threads; i ++) {
+	pthread_join(tids[i], &count);
+	*explored += (long) (intptr_t) count;
+    }
+
+    x = width - 1;
+    y = height - 1;
+    length = 1;
+
+    while (x != 0 || y != 0) {
+	if (maze[y][x].from == 1)
+	    x --;
+	else if (maze[y][x].from == -1)
+	    x ++;
+	else if (maze[y][x].from == width)
+	    y --;
+	else if (maze[y][x].from == -width)
+	    y ++;
+	else
+	    abort();
+
+	length ++;
+    }
+
+    for (i = 0; i < threads; i ++)
+	destroyDeque(deques[i]);
+
+    free(claimed);
+    free(tids);
+    free(deques);
+    return length;
+}
+
+
+/*
+ * Function:	runHeadless
+ *
+ * Description:	Generate a maze of the current size, solve it with the
+ *		given number of threads, and report the result.
+ */
+
+static void runHeadless(int threads)
+{
+    int length;
+    long explored;
+    double elapsed;
+    struct timespec start, stop;
+
+
+    createMaze();
+    initMaze();
+    list = createList_coord();
+    buildMaze(0, 0);
+    destroyList_coord(list);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    length = solveMazeParallel(threads, &explored);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    elapsed = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("%d x %d maze, %d threads: path of %d cells, %ld cells explored in %.3f s\n",
+	width, height, threads, length, explored, elapsed);
+}
+
+
 /*
  * Function:	main
  *
  * Description:	Driver function for the maze application.
  */
 
-int main(void)
+int main(int argc, char *argv[])
 {
-    int x, y;
+    int c, x, y, threads;
     WINDOW *win;
 
 
+    threads = 0;
+    width = height = DEFAULT_SIZE;
+
+    while ((c = getopt(argc, argv, "t:w:h:")) != -1) {
+	if (c == 't' && atoi(optarg) > 0)
+	    threads = atoi(optarg);
+
+	else if (c == 'w' && atoi(optarg) > 1 && atoi(optarg) <= SHRT_MAX)
+	    width = atoi(optarg);
+
+	else if (c == 'h' && atoi(optarg) > 1 && atoi(optarg) <= SHRT_MAX)
+	    height = atoi(optarg);
+
+	else {
+	    fprintf(stderr, "usage: %s [-t threads [-w width] [-h height]]\n", argv[0]);
+	    exit(EXIT_FAILURE);
+	}
+    }
+
+    if (threads > 0) {
+	runHeadless(threads);
+	exit(EXIT_SUCCESS);
+    }
+
     win = initscr();
     curs_set(0);
     getmaxyx(win, y, x);
     width = x / 2 - 1;
     height = y / 2 - 1;
     createMaze();
+    pool = createListPool();
 
     do {
 	clear();
 	refresh();
 	initMaze();
 
-	list = createList();
+	list = createListWithAllocator_coord(listPoolAlloc, listPoolFree, pool);
 	buildMaze(0, 0);
-	destroyList(list);
+	destroyList_coord(list);
 
 	printMaze();
 
-	list = createList();
+	list = createListWithAllocator_coord(listPoolAlloc, listPoolFree, pool);
 	solveMaze();
-	destroyList(list);
+	destroyList_coord(list);
 
 	move(height * 2 + 1, 0);
 	printw("Press 'q' to quit or any other key to run again.");
 	refresh();
     } while (getchar() != 'q');
 
+    destroyListPool(pool);
     clear();
     refresh();
     endwin();
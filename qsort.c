@@ -4,77 +4,115 @@
  * Copyright:	2020, Darren C. Atkinson
  *
  * Description:	Reads words from a text file whose name is given as the
- *		first and only command-line argument.  The words are stored
- *		in a list that is then sorted using quicksort, and the words
- *		are then displayed in sorted order.
+ *		only command-line argument other than options.  The words
+ *		are stored in a list that is then sorted in place using
+ *		the list's introsort, and the words are then displayed in
+ *		sorted order.  With the -j option the sort uses the given
+ *		number of threads.  The list is created with room for the
+ *		number of words estimated from a sample of the file, so
+ *		that reading them rarely allocates a node.  With the -H
+ *		option the list's nodes and the sort's buffers are mapped
+ *		on huge pages, for very large inputs.  The file is scanned
+ *		and the output formatted by the functions in fastio.h,
+ *		and with the -p option the file is scanned on a second
+ *		thread while the list is built.  The words are copied
+ *		into an arena, freed at once, and each is stored in the
+ *		list beside its first eight bytes packed into an integer,
+ *		so that most comparisons need not follow the pointer.
  */
 
 # include <stdio.h>
 # include <stdlib.h>
 # include <string.h>
+# include <limits.h>
+# include <stdbool.h>
+# include <ctype.h>
+# include <unistd.h>
+# include <sys/stat.h>
 # include "list.h"
+# include "listtype.h"
+# include "arena.h"
+# include "fastio.h"
 
 
-# define MAX_WORD_LENGTH 30		/* maximum length of a single word */
+# define OUTPUT_BATCH	4096		/* words removed at a time */
+# define SAMPLE_LENGTH	65536		/* bytes read to estimate the count */
+
+DEFINE_LIST(word, WORD)
 
 
 /*
- * Function:	partition
+ * Function:	compare
  *
- * Description:	Choose the first element in the sublist as the pivot and
- *		partition the sublist around the pivot.  Hoare's partition
- *		scheme is used: https://en.wikipedia.org/wiki/Quicksort.
+ * Description:	Compare two words for listSort, which passes the addresses
+ *		of the list items.  The items hold each word's prefix, so
+ *		the words themselves are rarely read.
  */
 
-static int partition(LIST *lp, int lo, int hi)
+static int compare(const void *a, const void *b)
 {
-    int i, j;
-    char *temp, *x;
+    return compareWords(a, b);
+}
 
 
-    x = getItem(lp, lo);
-    i = lo - 1;
-    j = hi + 1;
+/*
+ * Function:	estimateWords
+ *
+ * Description:	Estimate the number of words in a file by counting those
+ *		in its first SAMPLE_LENGTH bytes and scaling by its size.
+ */
 
-    while (i < j) {
-	do
-	    j = j - 1;
-	while (strcmp(getItem(lp, j), x) > 0);
+static int estimateWords(const char *path)
+{
+    char buf[SAMPLE_LENGTH];
+    size_t i, n;
+    long words;
+    struct stat st;
+    FILE *fp;
 
-	do
-	    i = i + 1;
-	while (strcmp(getItem(lp, i), x) < 0);
 
-	if (i < j) {
-	    temp = getItem(lp, i);
-	    setItem(lp, i, getItem(lp, j));
-	    setItem(lp, j, temp);
-	}
+    fp = fopen(path, "r");
+
+    if (fp == NULL)
+	return 0;
+
+    if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode)) {
+	fclose(fp);
+	return 0;
     }
 
-    return j;
+    n = fread(buf, 1, sizeof(buf), fp);
+    fclose(fp);
+    words = 0;
+
+    for (i = 0; i < n; i ++)
+	if (!isspace((unsigned char) buf[i]) && (i == 0 || isspace((unsigned char) buf[i - 1])))
+	    words ++;
+
+    if (n == 0 || words == 0)
+	return 0;
+
+    words = (double) words * st.st_size / n;
+    return words < INT_MAX ? words : INT_MAX;
 }
 
 
 /*
- * Function:	quickSort
+ * Function:	fileLength
  *
- * Description:	Recursively sort the given sublist using the quicksort
- *		sorting algorithm: partition the sublist around a pivot,
- *		recursively sort the lower half of the list, and finally
- *		recursively sort the upper half of the list.
+ * Description:	Return the length of a regular file, or zero if it is not
+ *		one, as the capacity of the arena that will hold its words.
  */
 
-static void quickSort(LIST *lp, int lo, int hi)
+static size_t fileLength(const char *path)
 {
-    int i;
+    struct stat st;
 
 
-    if (hi > lo) {
-	i = partition(lp, lo, hi);
-	quickSort(lp, lo, i);
-	quickSort(lp, i + 1, hi);
-    }
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+	return 0;
+
+    return st.st_size;
 }
 
 
@@ -86,43 +124,80 @@ static void quickSort(LIST *lp, int lo, int hi)
 
 int main(int argc, char *argv[])
 {
-    FILE *fp;
-    LIST *words;
-    char word[MAX_WORD_LENGTH+1];
+    LIST_word *words;
+    WORD batch[OUTPUT_BATCH];
+    ARENA *text;
+    size_t length;
+    int c, i, n, nthreads;
+    bool huge, pipelined;
+    INPUT *in;
+    OUTPUT *out;
+
+
+    /* Check the options and arguments and try to open the file. */
+
+    nthreads = 1;
+    huge = pipelined = false;
+
+    while ((c = getopt(argc, argv, "j:Hp")) != -1) {
+	if (c == 'j' && atoi(optarg) > 0)
+	    nthreads = atoi(optarg);
+
+	else if (c == 'H')
+	    huge = true;
 
+	else if (c == 'p')
+	    pipelined = true;
 
-    /* Check the number of arguments and try to open the file. */
+	else {
+	    fprintf(stderr, "usage: %s [-j threads] [-H] [-p] file\n", argv[0]);
+	    exit(EXIT_FAILURE);
+	}
+    }
 
-    if (argc != 2) {
+    if (optind != argc - 1) {
 	fprintf(stderr, "missing filename\n");
 	exit(EXIT_FAILURE);
     }
 
-    fp = fopen(argv[1], "r");
+    in = openInput(argv[optind]);
 
-    if (fp == NULL) {
+    if (in == NULL) {
 	fprintf(stderr, "cannot open file\n");
 	exit(EXIT_FAILURE);
     }
 
 
-    /* Read each word into the buffer and add it to the list. */
+    /* Scan the words and add each to the list, with its text in the arena.
+       Every word and the byte after it fit within the file, plus one byte
+       for the last word if the file does not end with a space. */
 
-    words = createList();
+    length = fileLength(argv[optind]);
+    text = createArena(length > 0 ? length + 1 : 0);
+    words = huge ? createMappedList_word() : createList_word();
+    listReserve(asList_word(words), estimateWords(argv[optind]));
+    loadWords(in, asList_word(words), text, pipelined);
+    closeInput(in);
 
-    while (fscanf(fp, "%s", word) == 1)
-	addLast(words, strdup(word));
 
-    fclose(fp);
+    /* Sort the words in the list and print them out in sorted order. */
 
+    listParallelSort(asList_word(words), compare, nthreads);
+    out = openOutput(STDOUT_FILENO);
 
-    /* Sort the words in the list and print them out in sorted order. */
+    while ((n = numItems_word(words)) > 0) {
+	if (n > OUTPUT_BATCH)
+	    n = OUTPUT_BATCH;
 
-    quickSort(words, 0, numItems(words) - 1);
+	removeFirstN_word(words, batch, n);
 
-    while (numItems(words) > 0)
-	printf("%s\n", (char *) removeFirst(words));
+	for (i = 0; i < n; i ++) {
+	    putBytes(out, batch[i].text, strlen(batch[i].text));
+	    putChar(out, '\n');
+	}
+    }
 
-    destroyList(words);
-    exit(EXIT_SUCCESS);
+    destroyList_word(words);
+    destroyArena(text);
+    exit(closeOutput(out) ? EXIT_SUCCESS : EXIT_FAILURE);
 }
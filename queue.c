@@ -0,0 +1,252 @@
+//filename: queue.c
+/**
+ * Defines a lock-free single-producer, single-consumer queue.
+ * The queue is a chain of nodes like a list's, but a node is filled once from the front by the
+ * producer and drained once from the front by the consumer, so it needs no ring arithmetic.
+ * The producer publishes each node's tail with a release store and links a new node the same
+ * way once the last one is full; the consumer reads them with acquire loads.  A drained node
+ * is handed back to the producer through a single spare slot, so a steady stream of items
+ * allocates nothing.
+ */
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "queue.h"
+
+#define QUEUE_NODE_LENGTH 1024
+#define CACHE_LINE 64
+
+/*
+ * The tail is written only by the producer and the head only by the consumer, so they live
+ * on separate cache lines, as do the items.
+ */
+typedef struct qnode {
+    _Atomic(struct qnode*) next;
+    _Atomic unsigned tail;
+    _Alignas(CACHE_LINE) unsigned head;
+    _Alignas(CACHE_LINE) char data[];
+} QNODE;
+
+struct queue {
+    size_t elemSize;
+    unsigned capacity;
+    _Atomic(QNODE*) spare;
+    _Atomic bool closed;
+    _Alignas(CACHE_LINE) QNODE* last;   /* the producer's node */
+    _Alignas(CACHE_LINE) QNODE* first;  /* the consumer's node */
+    unsigned limit;                     /* the consumer's copy of the tail of its node */
+};
+
+/**
+ * Makes an empty node, reusing the spare node if the consumer has left one.  Called by the
+ * producer only.
+ *
+ * @param qp the queue that will own the node
+ * @return the empty node
+ * @timeComplexity O(1)
+ */
+static QNODE* obtainQueueNode(QUEUE* qp) {
+    QNODE* np = atomic_exchange_explicit(&qp->spare, NULL, memory_order_acquire);
+    if (np == NULL) {
+        size_t size = sizeof(QNODE) + (size_t) qp->capacity * qp->elemSize;
+        np = aligned_alloc(CACHE_LINE, (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE);
+        assert(np != NULL);
+    }
+    atomic_init(&np->next, NULL);
+    atomic_init(&np->tail, 0);
+    np->head = 0;
+    return np;
+}
+
+/**
+ * Creates a new empty queue of items of the given size.
+ *
+ * @param elemSize the size of each item in bytes
+ * @return the new queue
+ * @timeComplexity O(1)
+ */
+QUEUE* createQueue(size_t elemSize) {
+    assert(elemSize > 0);
+    QUEUE* qp = aligned_alloc(CACHE_LINE, sizeof(QUEUE));
+    assert(qp != NULL);
+    qp->elemSize = elemSize;
+    qp->capacity = QUEUE_NODE_LENGTH;
+    atomic_init(&qp->spare, NULL);
+    atomic_init(&qp->closed, false);
+    qp->last = qp->first = obtainQueueNode(qp);
+    qp->limit = 0;
+    return qp;
+}
+
+/**
+ * Destroys the queue and frees all memory associated with it, along with any items still in
+ * it.  Neither thread may be using the queue.
+ *
+ * @param qp the queue to destroy
+ * @timeComplexity O(M) where M is the number of nodes
+ */
+void destroyQueue(QUEUE* qp) {
+    assert(qp != NULL);
+    QNODE* np = qp->first;
+    while (np != NULL) {
+        QNODE* next = atomic_load_explicit(&np->next, memory_order_relaxed);
+        free(np);
+        np = next;
+    }
+    free(atomic_load_explicit(&qp->spare, memory_order_relaxed));
+    free(qp);
+}
+
+/**
+ * Returns the producer's node with room for at least one more item, linking a new node after
+ * the current one if it is full.
+ *
+ * @param qp the queue
+ * @return the node
+ * @timeComplexity O(1)
+ */
+static inline QNODE* producerNode(QUEUE* qp) {
+    QNODE* np = qp->last;
+    if (atomic_load_explicit(&np->tail, memory_order_relaxed) == qp->capacity) {
+        QNODE* next = obtainQueueNode(qp);
+        atomic_store_explicit(&np->next, next, memory_order_release);
+        qp->last = np = next;
+    }
+    return np;
+}
+
+/**
+ * Adds an item to the end of the queue.  Called by the producer only.
+ *
+ * @param qp the queue to add to
+ * @param elem the address of the item to copy in (cant be null)
+ * @timeComplexity O(1)
+ */
+void queuePush(QUEUE* qp, const void* elem) {
+    assert(qp != NULL && elem != NULL);
+    QNODE* np = producerNode(qp);
+    unsigned tail = atomic_load_explicit(&np->tail, memory_order_relaxed);
+    memcpy(np->data + (size_t) tail * qp->elemSize, elem, qp->elemSize);
+    atomic_store_explicit(&np->tail, tail + 1, memory_order_release);
+}
+
+/**
+ * Adds n items to the end of the queue, in order, publishing them a node at a time.  Called by
+ * the producer only.
+ *
+ * @param qp the queue to add to
+ * @param items the items to add (cant be null)
+ * @param n the number of items
+ * @timeComplexity O(n)
+ */
+void queuePushN(QUEUE* qp, const void* items, int n) {
+    assert(qp != NULL && n >= 0);
+    const char* src = items;
+    while (n > 0) {
+        QNODE* np = producerNode(qp);
+        unsigned tail = atomic_load_explicit(&np->tail, memory_order_relaxed);
+        unsigned run = qp->capacity - tail < (unsigned) n ? qp->capacity - tail : (unsigned) n;
+        memcpy(np->data + (size_t) tail * qp->elemSize, src, (size_t) run * qp->elemSize);
+        atomic_store_explicit(&np->tail, tail + run, memory_order_release);
+        src += (size_t) run * qp->elemSize;
+        n -= run;
+    }
+}
+
+/**
+ * Marks the queue as closed, meaning the producer will add no more items.  Called by the
+ * producer only.
+ *
+ * @param qp the queue to close
+ * @timeComplexity O(1)
+ */
+void queueClose(QUEUE* qp) {
+    assert(qp != NULL);
+    atomic_store_explicit(&qp->closed, true, memory_order_release);
+}
+
+/**
+ * Returns the consumer's node with at least one item to remove, moving on to the next node and
+ * recycling the drained one if necessary.
+ *
+ * @param qp the queue
+ * @return the node, or null if the queue is empty for now
+ * @timeComplexity O(1)
+ */
+static inline QNODE* consumerNode(QUEUE* qp) {
+    QNODE* np = qp->first;
+    if (np->head < qp->limit)
+        return np;
+    qp->limit = atomic_load_explicit(&np->tail, memory_order_acquire);
+    if (np->head < qp->limit)
+        return np;
+    if (np->head < qp->capacity)
+        return NULL;
+    QNODE* next = atomic_load_explicit(&np->next, memory_order_acquire);
+    if (next == NULL)
+        return NULL;
+    qp->first = next;
+    free(atomic_exchange_explicit(&qp->spare, np, memory_order_acq_rel));
+    qp->limit = atomic_load_explicit(&next->tail, memory_order_acquire);
+    return next->head < qp->limit ? next : NULL;
+}
+
+/**
+ * Removes the item at the front of the queue, if there is one.  Called by the consumer only.
+ *
+ * @param qp the queue to remove from
+ * @param out where to copy the item (can be null)
+ * @return true if an item was removed, false if the queue is empty for now
+ * @timeComplexity O(1)
+ */
+bool queuePop(QUEUE* qp, void* out) {
+    assert(qp != NULL);
+    QNODE* np = consumerNode(qp);
+    if (np == NULL)
+        return false;
+    if (out != NULL)
+        memcpy(out, np->data + (size_t) np->head * qp->elemSize, qp->elemSize);
+    np->head++;
+    return true;
+}
+
+/**
+ * Removes up to n items from the front of the queue, as many as are available.  Called by the
+ * consumer only.
+ *
+ * @param qp the queue to remove from
+ * @param out where to copy the items (cant be null)
+ * @param n the largest number of items to remove
+ * @return the number of items removed, which is zero if the queue is empty for now
+ * @timeComplexity O(n)
+ */
+int queuePopN(QUEUE* qp, void* out, int n) {
+    assert(qp != NULL && out != NULL && n >= 0);
+    char* dst = out;
+    int done = 0;
+    QNODE* np;
+    while (done < n && (np = consumerNode(qp)) != NULL) {
+        unsigned run = qp->limit - np->head;
+        if (run > (unsigned) (n - done))
+            run = n - done;
+        memcpy(dst, np->data + (size_t) np->head * qp->elemSize, (size_t) run * qp->elemSize);
+        np->head += run;
+        dst += (size_t) run * qp->elemSize;
+        done += run;
+    }
+    return done;
+}
+
+/**
+ * Returns whether the producer has closed the queue and every item has been removed.  Called by
+ * the consumer only.
+ *
+ * @param qp the queue
+ * @return true if no more items will arrive
+ * @timeComplexity O(1)
+ */
+bool queueFinished(QUEUE* qp) {
+    assert(qp != NULL);
+    return atomic_load_explicit(&qp->closed, memory_order_acquire) && consumerNode(qp) == NULL;
+}
@@ -0,0 +1,38 @@
+/*
+ * File:	queue.h
+ *
+ * Description:	This file contains the public function and type
+ *		declarations for a single-producer, single-consumer queue
+ *		of fixed-size items stored by value.  One thread may add
+ *		items while another removes them, with no locks: like a
+ *		list, the queue is a chain of nodes, and each node's
+ *		count of items is published with C11 atomics.  The push
+ *		functions may only be called by the producer, and the
+ *		pop functions and queueFinished only by the consumer.
+ */
+
+# ifndef QUEUE_H
+# define QUEUE_H
+
+# include <stddef.h>
+# include <stdbool.h>
+
+typedef struct queue QUEUE;
+
+extern QUEUE *createQueue(size_t elemSize);
+
+extern void destroyQueue(QUEUE *qp);
+
+extern void queuePush(QUEUE *qp, const void *elem);
+
+extern void queuePushN(QUEUE *qp, const void *items, int n);
+
+extern void queueClose(QUEUE *qp);
+
+extern bool queuePop(QUEUE *qp, void *out);
+
+extern int queuePopN(QUEUE *qp, void *out, int n);
+
+extern bool queueFinished(QUEUE *qp);
+
+# endif /* QUEUE_H */
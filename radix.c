@@ -4,25 +4,54 @@
  * Copyright:	2020, Darren C. Atkinson
  *
  * Description:	Read a sequence of non-negative integers from the
- *		standard input and sort then using radix sort.  Each
- *		integer in the list is dropped into a bucket by its least
- *		significant digit.  After all integers are placed in
- *		buckets, the buckets are copied back into the list and we
- *		repeat the process, but with the next most significant
- *		digit.  After all digits have been processed, the list is
- *		sorted!  Since the buckets need to preserve the order of
- *		insertion, we need to implement a queue.  A list provides
- *		this functionality for us.  The algorithm can be found at
- *		wikipedia.org/wiki/Radix_sort.
+ *		standard input and sort then using radix sort.  The
+ *		integers are sorted a byte at a time, starting with the
+ *		least significant byte: a histogram of each byte's values
+ *		gives the position in a scratch buffer of every bucket,
+ *		and each integer is copied into the next slot of its
+ *		bucket, preserving the order from the previous pass.
+ *		After all bytes have been processed, the list is sorted!
+ *		Bytes that are the same in every integer are skipped.
+ *		The list does the work in listRadixSort, or with the -j
+ *		option in listParallelRadixSort using the given number of
+ *		threads.  With the -H option the list's nodes and the sort's
+ *		buffers are mapped on huge pages, for very large inputs.
+ *		The -w option saves the numbers read to a snapshot file
+ *		before sorting, and the -r option maps such a file in
+ *		place of reading the standard input, so that a large
+ *		input is parsed only once.  The input is scanned and the
+ *		output formatted by the functions in fastio.h, and with
+ *		the -p option the input is scanned on a second thread
+ *		while the list is built.
+ *		The algorithm can be found at wikipedia.org/wiki/Radix_sort.
  */
 
-# include <math.h>
 # include <stdio.h>
 # include <stdlib.h>
-# include <assert.h>
-# include "list.c"
+# include <stdint.h>
+# include <limits.h>
+# include <stdbool.h>
+# include <unistd.h>
+# include "list.h"
+# include "listtype.h"
+# include "fastio.h"
 
-# define r 10
+# define OUTPUT_BATCH	4096		/* numbers removed at a time */
+
+DEFINE_LIST(int, int)
+
+
+/*
+ * Function:	key
+ *
+ * Description:	Return the radix sort key of the integer at the given
+ *		address, which is just its value.
+ */
+
+static uint64_t key(const void *p)
+{
+    return *(const int *) p;
+}
 
 
 /*
@@ -31,69 +60,103 @@
  * Description:	Driver function for the radix application.
  */
 
-int main(void)
+int main(int argc, char *argv[])
 {
-    int i, x, niter, div, max, *p;
-    LIST *a, *lists[r];
+    int c, i, n, nthreads, batch[OUTPUT_BATCH];
+    bool huge, pipelined;
+    char *save, *load;
+    LIST_int *a;
+    INPUT *in;
+    OUTPUT *out;
 
 
-    max = 0;
-    a = createList();
+    nthreads = 1;
+    huge = pipelined = false;
+    save = load = NULL;
 
-    for (i = 0; i < r; i ++)
-	lists[i] = createList();
+    while ((c = getopt(argc, argv, "j:Hpw:r:")) != -1) {
+	if (c == 'j' && atoi(optarg) > 0)
+	    nthreads = atoi(optarg);
 
+	else if (c == 'H')
+	    huge = true;
 
-    /* Read in the numbers and record the maximum as we go along. */
+	else if (c == 'p')
+	    pipelined = true;
 
-    while (scanf("%d", &x) == 1) {
-	if (x >= 0) {
-	    p = malloc(sizeof(int));
-	    assert(p != NULL);
-	    *p = x;
+	else if (c == 'w')
+	    save = optarg;
 
-	    addLast(a, p);
+	else if (c == 'r')
+	    load = optarg;
 
-	    if (x > max)
-		max = x;
-
-	} else {
-	    fprintf(stderr, "Sorry, only non-negative values allowed.\n");
+	else {
+	    fprintf(stderr, "usage: %s [-j threads] [-H] [-p] [-w snapshot | -r snapshot]\n", argv[0]);
 	    exit(EXIT_FAILURE);
 	}
     }
 
-    div = 1;
-    niter = ceil(log(max + 1) / log(r));
 
-    while (niter --) {
+    /* Map the numbers from a snapshot, or read them in.  The list
+       holds the numbers themselves rather than pointers to them. */
 
+    if (load != NULL) {
+	a = (LIST_int *) listMap(load);
+
+	if (a == NULL || asList_int(a)->elemSize != sizeof(int)) {
+	    fprintf(stderr, "cannot map snapshot %s\n", load);
+	    exit(EXIT_FAILURE);
+	}
 
-	/* Move the numbers from the list to the buckets. */
+    } else {
+	a = huge ? createMappedList_int() : createList_int();
+	in = openInput(NULL);
 
-	while (numItems(a) > 0) {
-	    p = removeFirst(a);
-	    addLast(lists[*p / div % r], p);
+	if (in == NULL) {
+	    fprintf(stderr, "cannot read the standard input\n");
+	    exit(EXIT_FAILURE);
 	}
 
+	loadInts(in, asList_int(a), pipelined);
+	c = peekInput(in);
 
-	/* Move the numbers from the buckets back into the list. */
+	if (c == '-') {
+	    fprintf(stderr, "Sorry, only non-negative values allowed.\n");
+	    exit(EXIT_FAILURE);
+	}
 
-	for (i = 0; i < r; i ++)
-	    while (numItems(lists[i]) > 0)
-		addLast(a, removeFirst(lists[i]));
+	if (c != -1) {
+	    fprintf(stderr, "Sorry, invalid input: expected integers no larger than %d.\n", INT_MAX);
+	    exit(EXIT_FAILURE);
+	}
 
-	div = div * r;
+	closeInput(in);
     }
 
+    if (save != NULL && !listSave(asList_int(a), save)) {
+	fprintf(stderr, "cannot save snapshot %s\n", save);
+	exit(EXIT_FAILURE);
+    }
 
-    /* Print out the numbers. */
+    listAdvise(asList_int(a), LIST_ADVISE_SEQUENTIAL);
+    listParallelRadixSort(asList_int(a), key, nthreads);
 
-    while (numItems(a) > 0) {
-	p = removeFirst(a);
-	printf("%d\n", *p);
-	free(p);
+
+    /* Print out the numbers, a batch at a time. */
+
+    out = openOutput(STDOUT_FILENO);
+
+    while ((n = numItems_int(a)) > 0) {
+	if (n > OUTPUT_BATCH)
+	    n = OUTPUT_BATCH;
+
+	removeFirstN_int(a, batch, n);
+
+	for (i = 0; i < n; i ++) {
+	    putUnsigned(out, batch[i]);
+	    putChar(out, '\n');
+	}
     }
 
-    exit(EXIT_SUCCESS);
+    exit(closeOutput(out) ? EXIT_SUCCESS : EXIT_FAILURE);
 }